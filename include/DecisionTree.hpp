@@ -1,9 +1,11 @@
 #pragma once
 #include "model.hpp"
 #include <Eigen/Dense>
+#include "types.hpp"
 #include <stdexcept>
 #include <iostream>
 #include <vector>
+#include <numeric>
 #include "LearningRateScheduler.hpp"
 #include "dataset.hpp"
 #include "optimizer.hpp"
@@ -11,28 +13,28 @@
 class TreeNode {
     private:
         int _feature;
-        double _threshold;
+        Scalar _threshold;
         TreeNode* _left;
         TreeNode* _right;
-        double _value;
+        Scalar _value;
         bool _is_leaf;
     
     public:
         // Constructor for leaf nodes
-        TreeNode(double value) : _feature(-1), _threshold(0), _left(nullptr), _right(nullptr), 
+        TreeNode(Scalar value) : _feature(-1), _threshold(0), _left(nullptr), _right(nullptr), 
                                _value(value), _is_leaf(true) {}
         
         // Constructor for internal nodes
-        TreeNode(int feature, double threshold, TreeNode* left, TreeNode* right) 
+        TreeNode(int feature, Scalar threshold, TreeNode* left, TreeNode* right) 
             : _feature(feature), _threshold(threshold), _left(left), _right(right), 
               _value(0), _is_leaf(false) {}
         
         bool is_leaf() const { return _is_leaf; }
         int get_feature() const { return _feature; }
-        double get_threshold() const { return _threshold; }
+        Scalar get_threshold() const { return _threshold; }
         TreeNode* get_left() const { return _left; }
         TreeNode* get_right() const { return _right; }
-        double get_value() const { return _value; }
+        Scalar get_value() const { return _value; }
         
         ~TreeNode() {
             delete _left;
@@ -45,9 +47,9 @@ class DecisionTree : public Model {
         TreeNode* _root;
         int _max_depth;
 
-        double _gini_impurity(const Eigen::VectorXd& y) const {
+        double _gini_impurity(const Eigen::Ref<const VectorXs>& y) const {
             // Count unique values and their frequencies
-            std::map<double, int> counts;
+            std::map<Scalar, int> counts;
             for(int i = 0; i < y.size(); i++) {
                 counts[y(i)]++;
             }
@@ -60,9 +62,9 @@ class DecisionTree : public Model {
             return impurity;
         }   
 
-        double _entropy(const Eigen::VectorXd& y) const {
+        double _entropy(const Eigen::Ref<const VectorXs>& y) const {
             // Count unique values and their frequencies
-            std::map<double, int> counts;
+            std::map<Scalar, int> counts;
             for(int i = 0; i < y.size(); i++) {
                 counts[y(i)]++;
             }
@@ -75,7 +77,8 @@ class DecisionTree : public Model {
             return entropy;
         }
 
-        double _information_gain(const Eigen::VectorXd& y, const Eigen::VectorXd& y1, const Eigen::VectorXd& y2) const {
+        double _information_gain(const Eigen::Ref<const VectorXs>& y, const Eigen::Ref<const VectorXs>& y1,
+                                 const Eigen::Ref<const VectorXs>& y2) const {
             double p = static_cast<double>(y1.size()) / y.size();
             double entropy = _entropy(y);
             double entropy1 = _entropy(y1);
@@ -83,47 +86,43 @@ class DecisionTree : public Model {
             return entropy - p * entropy1 - (1 - p) * entropy2;
         }
 
-        TreeNode* _build_tree(const Dataset& dataset, int depth) {
-            Eigen::VectorXd y = dataset.getY();
-            if (y.size() == 0) return nullptr;
+        // Builds the subtree for the given rows of X; the training data is never copied,
+        // each node only carries the indices of its rows
+        TreeNode* _build_tree(const Eigen::Ref<const MatrixXs>& X, const Eigen::Ref<const VectorXs>& y_all,
+                              const std::vector<int>& rows, int depth) {
+            if (rows.empty()) return nullptr;
+            VectorXs y(rows.size());
+            for (size_t k = 0; k < rows.size(); k++) {
+                y(k) = y_all(rows[k]);
+            }
             
             if (depth >= _max_depth || _gini_impurity(y) == 0) {
                 return new TreeNode(y.mean());
             }
             
             int best_feature = -1;
-            double best_threshold = -1;
+            Scalar best_threshold = -1;
             double best_gain = -1;
+
+            // Split buffers, reused for every candidate threshold
+            VectorXs y1(rows.size());
+            VectorXs y2(rows.size());
             
-            for (int i = 0; i < dataset.getX().cols(); i++) {
-                for (int j = 0; j < dataset.getX().rows(); j++) {
-                    double threshold = dataset.getX()(j, i);
+            for (int i = 0; i < X.cols(); i++) {
+                for (int j : rows) {
+                    Scalar threshold = X(j, i);
                     
-                    // Count samples for each split
+                    // Split the targets
                     int left_count = 0, right_count = 0;
-                    for(int k = 0; k < y.size(); k++) {
-                        if(dataset.getX()(k, i) < threshold) {
-                            left_count++;
-                        } else {
-                            right_count++;
-                        }
-                    }
-                    
-                    // Pre-allocate vectors
-                    Eigen::VectorXd y1(left_count);
-                    Eigen::VectorXd y2(right_count);
-                    
-                    // Fill the vectors
-                    int left_idx = 0, right_idx = 0;
-                    for(int k = 0; k < y.size(); k++) {
-                        if(dataset.getX()(k, i) < threshold) {
-                            y1(left_idx++) = y(k);
+                    for(size_t k = 0; k < rows.size(); k++) {
+                        if(X(rows[k], i) < threshold) {
+                            y1(left_count++) = y(k);
                         } else {
-                            y2(right_idx++) = y(k);
+                            y2(right_count++) = y(k);
                         }
                     }
                     
-                    double gain = _information_gain(y, y1, y2);
+                    double gain = _information_gain(y, y1.head(left_count), y2.head(right_count));
                     if (gain > best_gain) {
                         best_gain = gain;
                         best_feature = i;
@@ -136,40 +135,22 @@ class DecisionTree : public Model {
                 return new TreeNode(y.mean());
             }
             
-            // Count samples for final split
-            int left_count = 0, right_count = 0;
-            for(int i = 0; i < dataset.getX().rows(); i++) {
-                if(dataset.getX()(i, best_feature) < best_threshold) {
-                    left_count++;
+            // Partition the rows for the children
+            std::vector<int> left_rows, right_rows;
+            for (int row : rows) {
+                if (X(row, best_feature) < best_threshold) {
+                    left_rows.push_back(row);
                 } else {
-                    right_count++;
+                    right_rows.push_back(row);
                 }
             }
             
-            // Pre-allocate matrices and vectors
-            Eigen::MatrixXd X1(left_count, dataset.getX().cols());
-            Eigen::MatrixXd X2(right_count, dataset.getX().cols());
-            Eigen::VectorXd y1(left_count);
-            Eigen::VectorXd y2(right_count);
-            
-            // Fill the matrices and vectors
-            int left_idx = 0, right_idx = 0;
-            for(int i = 0; i < dataset.getX().rows(); i++) {
-                if(dataset.getX()(i, best_feature) < best_threshold) {
-                    X1.row(left_idx) = dataset.getX().row(i);
-                    y1(left_idx++) = y(i);
-                } else {
-                    X2.row(right_idx) = dataset.getX().row(i);
-                    y2(right_idx++) = y(i);
-                }
-            }
-            
-            TreeNode* left = _build_tree(Dataset(X1, y1), depth + 1);
-            TreeNode* right = _build_tree(Dataset(X2, y2), depth + 1);
+            TreeNode* left = _build_tree(X, y_all, left_rows, depth + 1);
+            TreeNode* right = _build_tree(X, y_all, right_rows, depth + 1);
             return new TreeNode(best_feature, best_threshold, left, right);
         }
 
-        double _predict(TreeNode* node, const Eigen::RowVectorXd& x) const {
+        Scalar _predict(TreeNode* node, const RowVectorXs& x) const {
             if (node == nullptr) return 0;
             if (node->is_leaf()) return node->get_value();
             if (x(node->get_feature()) < node->get_threshold()) {
@@ -182,18 +163,22 @@ class DecisionTree : public Model {
         DecisionTree(int max_depth = 5) : _root(nullptr), _max_depth(max_depth) {}
         
         void fit(const Dataset& train) override {
-            _root = _build_tree(train, 0);
+            delete _root;
+            _root = nullptr;
+            std::vector<int> rows(train.getNumRows());
+            std::iota(rows.begin(), rows.end(), 0);
+            _root = _build_tree(train.getX(), train.getY(), rows, 0);
         }
         
-        Eigen::VectorXd predict(const Eigen::MatrixXd& X) const override {
-            Eigen::VectorXd predictions(X.rows());
+        VectorXs predict(const MatrixXs& X) const override {
+            VectorXs predictions(X.rows());
             for(int i = 0; i < X.rows(); i++) {
                 predictions(i) = _predict(_root, X.row(i));
             }
             return predictions;
         }
         
-        void update_parameters(Eigen::VectorXd gradients, double rate) override {
+        void update_parameters(const VectorXs &gradients, double rate) override {
             throw std::logic_error("DecisionTree does not support parameter updates.");
         }
         
@@ -1,5 +1,6 @@
 #pragma once
 #include <Eigen/Dense>
+#include "types.hpp"
 #include <random>
 #include <limits>
 #include <string>
@@ -9,7 +10,7 @@ class KMeans
 private:
     int k_;
     int max_iters_;
-    Eigen::MatrixXd centroids_; // [k x n_features]
+    MatrixXs centroids_; // [k x n_features]
     std::mt19937 rng_; // Random number generator
 
 public:
@@ -21,7 +22,7 @@ public:
             throw std::invalid_argument("Maximum iterations must be positive");
         }
     }
-    void fit(const Eigen::MatrixXd &X) {
+    void fit(const MatrixXs &X) {
         if (X.rows() == 0 || X.cols() == 0) {
             throw std::invalid_argument("Input matrix X cannot be empty");
         }
@@ -30,7 +31,7 @@ public:
         }
 
         // Initialize centroids randomly
-        centroids_ = Eigen::MatrixXd::Zero(k_, X.cols());
+        centroids_ = MatrixXs::Zero(k_, X.cols());
         std::uniform_int_distribution<int> dist(0, X.rows() - 1);
         for (int i = 0; i < k_; i++) {
             centroids_.row(i) = X.row(dist(rng_));
@@ -42,7 +43,7 @@ public:
             Eigen::VectorXi labels = assign_points(X);
             
             // Update centroids
-            Eigen::MatrixXd new_centroids = update_centroids(X, labels);
+            MatrixXs new_centroids = update_centroids(X, labels);
             
             // Check for convergence
             if ((new_centroids - centroids_).norm() < 1e-6) {
@@ -52,7 +53,7 @@ public:
         }
     }
 
-    Eigen::VectorXi predict(const Eigen::MatrixXd &X) const {
+    Eigen::VectorXi predict(const MatrixXs &X) const {
         if (X.rows() == 0 || X.cols() == 0) {
             throw std::invalid_argument("Input matrix X cannot be empty");
         }
@@ -62,8 +63,8 @@ public:
         return assign_points(X);
     }
 
-    Eigen::MatrixXd update_centroids(const Eigen::MatrixXd &X, const Eigen::VectorXi &labels) const {
-        Eigen::MatrixXd new_centroids = Eigen::MatrixXd::Zero(k_, X.cols());
+    MatrixXs update_centroids(const MatrixXs &X, const Eigen::VectorXi &labels) const {
+        MatrixXs new_centroids = MatrixXs::Zero(k_, X.cols());
         Eigen::VectorXi cluster_sizes = Eigen::VectorXi::Zero(k_);
 
         // Sum up points in each cluster
@@ -83,15 +84,15 @@ public:
         return new_centroids;
     }
 
-    Eigen::VectorXi assign_points(const Eigen::MatrixXd &X) const {
+    Eigen::VectorXi assign_points(const MatrixXs &X) const {
         Eigen::VectorXi labels(X.rows());
         
         for (int i = 0; i < X.rows(); i++) {
-            double min_dist = std::numeric_limits<double>::infinity();
+            Scalar min_dist = std::numeric_limits<Scalar>::infinity();
             int min_idx = 0;
             
             for (int j = 0; j < k_; j++) {
-                double dist = (X.row(i) - centroids_.row(j)).squaredNorm();
+                Scalar dist = (X.row(i) - centroids_.row(j)).squaredNorm();
                 if (dist < min_dist) {
                     min_dist = dist;
                     min_idx = j;
@@ -104,7 +105,7 @@ public:
     }
 
     // Getter for centroids
-    Eigen::MatrixXd get_centroids() const {
+    MatrixXs get_centroids() const {
         return centroids_;
     }
 
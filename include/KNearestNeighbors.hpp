@@ -1,6 +1,7 @@
 #pragma once
 #include "model.hpp"
 #include <Eigen/Dense>
+#include "types.hpp"
 #include <stdexcept>
 #include <iostream>
 #include "LearningRateScheduler.hpp"
@@ -17,7 +18,8 @@ class KNearestNeighbors : public Model
         Dataset _data;
         int _k = 3; // Number of neighbors to consider, default is 3
 
-        double EuclideanDistance(const Eigen::RowVectorXd &a, const Eigen::RowVectorXd &b) const
+        Scalar EuclideanDistance(const Eigen::Ref<const RowVectorXs, 0, Eigen::InnerStride<>> &a,
+                                 const Eigen::Ref<const RowVectorXs, 0, Eigen::InnerStride<>> &b) const
         {
             return (a - b).norm(); // Calculate the Euclidean distance between two vectors
         }
@@ -25,7 +27,7 @@ class KNearestNeighbors : public Model
         
     public:
 
-        KNearestNeighbors(int k = 3) : _k(k), _data(Eigen::MatrixXd(), Eigen::VectorXd())
+        KNearestNeighbors(int k = 3) : _k(k), _data(MatrixXs(), VectorXs())
         {
             if (k <= 0)
             {
@@ -35,24 +37,24 @@ class KNearestNeighbors : public Model
 
         void fit(const Dataset &train) override
         {
-            _data = Dataset(train.getX(), train.getY());
+            _data = train;  // shares the training storage, no copy
         }
 
         // Fit the model to the training data
-        void fit(const Eigen::MatrixXd &X, const Eigen::VectorXd &y) 
+        void fit(const MatrixXs &X, const VectorXs &y) 
         {
             // Store the training data
             _data = Dataset(X, y);
         }
 
         // Predict the target values for the given input features
-        Eigen::VectorXd predict(const Eigen::MatrixXd &X) const override
+        VectorXs predict(const MatrixXs &X) const override
         {
             if (X.rows() == 0 || X.cols() != _data.getNumFeatures())
             {
                 throw std::invalid_argument("Input matrix dimensions do not match training data.");
             }
-            Eigen::VectorXd predictions(X.rows());
+            VectorXs predictions(X.rows());
             for (int i = 0; i < X.rows(); ++i)
             {
                 // For each input row, find the k nearest neighbors and predict the target value
@@ -62,7 +64,7 @@ class KNearestNeighbors : public Model
         }
 
         // Predict a single instance based on the nearest neighbors
-        double predictSingle(const Eigen::RowVectorXd &x) const
+        double predictSingle(const RowVectorXs &x) const
         {
             if (_data.getNumRows() == 0) 
             {
@@ -70,12 +72,15 @@ class KNearestNeighbors : public Model
             }
 
             // Create a vector to store distances and corresponding indices
-            std::vector<std::pair<double, int>> distances;
+            std::vector<std::pair<Scalar, int>> distances;
 
             // Calculate distances from the input vector to all training data points
-            for (int i = 0; i < _data.getNumRows(); ++i)
+            const Eigen::Ref<const MatrixXs> X = _data.getX();
+            const Eigen::Ref<const VectorXs> y = _data.getY();
+            distances.reserve(X.rows());
+            for (int i = 0; i < X.rows(); ++i)
             {
-                double dist = EuclideanDistance(x, _data.getX().row(i));
+                Scalar dist = EuclideanDistance(x, X.row(i));
                 distances.emplace_back(dist, i);
             }
 
@@ -86,14 +91,14 @@ class KNearestNeighbors : public Model
             double sum = 0.0;
             for (int i = 0; i < _k && i < distances.size(); ++i)
             {
-                sum += _data.getY()(distances[i].second);
+                sum += y(distances[i].second);
             }
             return sum / std::min(_k, static_cast<int>(distances.size())); // Handle case where there are fewer than k neighbors
 
         }
 
         // Update model parameters (not applicable for KNN, but required by the Model interface)
-        void update_parameters(Eigen::VectorXd gradients, double rate) override
+        void update_parameters(const VectorXs &gradients, double rate) override
         {
             throw std::logic_error("KNearestNeighbors does not support parameter updates.");
         }
@@ -2,10 +2,24 @@
 #include <iostream>
 #include <cmath>
 #include <string>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
 
 class LearningRateScheduler {
 public:
     virtual double getRate(int epoch) const = 0;
+    // Rate for one optimizer step (mini-batch update), counted from 0 over the whole run.
+    // Schedules that only change per epoch keep the default.
+    virtual double getRate(long long /*step*/, int epoch) const { return getRate(epoch); }
+    // Called by the optimizer with each epoch's loss, for schedules that adapt to progress.
+    // The optimizer holds the scheduler by const reference, so such schedules keep their
+    // state mutable: one instance of an adaptive schedule must not be shared by fits that
+    // run at the same time (such as parallel cross-validation folds); give each its own.
+    virtual void reportLoss(double /*loss*/, int /*epoch*/) const {}
+    // Called at the start of every training run
+    virtual void reset() const {}
     virtual std::string name() const = 0;
     virtual std::string description() const = 0;
     virtual std::string formula() const = 0;
@@ -15,7 +29,8 @@ public:
 class ConstantLearningRateScheduler : public LearningRateScheduler {
 public:
     ConstantLearningRateScheduler(double rate) : rate_(rate) {}
-    double getRate(int epoch) const override { return rate_; }
+    using LearningRateScheduler::getRate;
+    double getRate(int /*epoch*/) const override { return rate_; }
     std::string name() const override { return "Constant Learning Rate"; }
     std::string description() const override { return "A constant learning rate that does not change during training."; }
     std::string formula() const override { return "lr = constant_value"; }
@@ -27,6 +42,7 @@ class ExponentialDecayLearningRateScheduler : public LearningRateScheduler {
 public:
     ExponentialDecayLearningRateScheduler(double init_rate, double decay_rate)
         : init_rate_(init_rate), decay_rate_(decay_rate) {}
+    using LearningRateScheduler::getRate;
     double getRate(int epoch) const override {
         return init_rate_ * std::exp(-decay_rate_ * epoch);
     }
@@ -37,3 +53,137 @@ private:
     double init_rate_;
     double decay_rate_;
 };
+
+inline constexpr double kSchedulePi = 3.14159265358979323846;
+
+// The schedules below count optimizer steps. Consulted per epoch only (getRate(epoch)), they
+// treat each epoch as one step.
+
+// Ramps the rate of another schedule up linearly over the first warmup_steps steps
+class LinearWarmupScheduler : public LearningRateScheduler {
+public:
+    LinearWarmupScheduler(std::shared_ptr<const LearningRateScheduler> schedule, long long warmup_steps)
+        : schedule_(std::move(schedule)), warmup_steps_(warmup_steps) {
+        if (!schedule_) throw std::invalid_argument("Schedule cannot be null.");
+        if (warmup_steps <= 0) throw std::invalid_argument("Number of warmup steps must be positive.");
+    }
+    double getRate(int epoch) const override { return getRate(static_cast<long long>(epoch), epoch); }
+    double getRate(long long step, int epoch) const override {
+        const double warmup = std::min(1.0, static_cast<double>(step + 1) / warmup_steps_);
+        return warmup * schedule_->getRate(step, epoch);
+    }
+    void reportLoss(double loss, int epoch) const override { schedule_->reportLoss(loss, epoch); }
+    void reset() const override { schedule_->reset(); }
+    std::string name() const override { return "Linear Warmup"; }
+    std::string description() const override { return "Scales another schedule's rate up linearly from near zero over the first steps, which keeps early updates from diverging."; }
+    std::string formula() const override { return "lr = min(1, (step + 1) / warmup_steps) * schedule(step)"; }
+private:
+    std::shared_ptr<const LearningRateScheduler> schedule_;
+    long long warmup_steps_;
+};
+
+// Anneals from max_rate to min_rate along half a cosine over total_steps, then holds min_rate
+class CosineAnnealingScheduler : public LearningRateScheduler {
+public:
+    CosineAnnealingScheduler(double max_rate, long long total_steps, double min_rate = 0.0)
+        : max_rate_(max_rate), min_rate_(min_rate), total_steps_(total_steps) {
+        if (max_rate <= 0.0 || min_rate < 0.0 || min_rate > max_rate) throw std::invalid_argument("Rates must satisfy 0 <= min_rate <= max_rate, max_rate > 0.");
+        if (total_steps <= 0) throw std::invalid_argument("Number of steps must be positive.");
+    }
+    double getRate(int epoch) const override { return getRate(static_cast<long long>(epoch), epoch); }
+    double getRate(long long step, int /*epoch*/) const override {
+        const double progress = std::min(1.0, static_cast<double>(step) / total_steps_);
+        return min_rate_ + 0.5 * (max_rate_ - min_rate_) * (1.0 + std::cos(kSchedulePi * progress));
+    }
+    std::string name() const override { return "Cosine Annealing"; }
+    std::string description() const override { return "Decays the rate from its maximum to its minimum along half a cosine wave."; }
+    std::string formula() const override { return "lr = lr_min + (lr_max - lr_min) * (1 + cos(pi * step / total_steps)) / 2"; }
+private:
+    double max_rate_;
+    double min_rate_;
+    long long total_steps_;
+};
+
+// One-cycle policy: the rate rises from max_rate / div_factor to max_rate over the first
+// warmup_fraction of total_steps, then anneals to max_rate / (div_factor * final_div_factor),
+// both along cosine curves
+class OneCycleScheduler : public LearningRateScheduler {
+public:
+    OneCycleScheduler(double max_rate, long long total_steps, double warmup_fraction = 0.3,
+                      double div_factor = 25.0, double final_div_factor = 1e4)
+        : max_rate_(max_rate), total_steps_(total_steps), warmup_fraction_(warmup_fraction),
+          div_factor_(div_factor), final_div_factor_(final_div_factor) {
+        if (max_rate <= 0.0) throw std::invalid_argument("Maximum rate must be positive.");
+        if (total_steps <= 0) throw std::invalid_argument("Number of steps must be positive.");
+        if (warmup_fraction < 0.0 || warmup_fraction >= 1.0) throw std::invalid_argument("Warmup fraction must be in [0, 1).");
+        if (div_factor < 1.0 || final_div_factor < 1.0) throw std::invalid_argument("Division factors must be at least 1.");
+    }
+    double getRate(int epoch) const override { return getRate(static_cast<long long>(epoch), epoch); }
+    double getRate(long long step, int /*epoch*/) const override {
+        const double initial_rate = max_rate_ / div_factor_;
+        const double final_rate = initial_rate / final_div_factor_;
+        const double warmup_steps = warmup_fraction_ * total_steps_;
+        if (step < warmup_steps) {
+            return anneal(initial_rate, max_rate_, step / warmup_steps);
+        }
+        return anneal(max_rate_, final_rate, std::min(1.0, (step - warmup_steps) / (total_steps_ - warmup_steps)));
+    }
+    std::string name() const override { return "One Cycle"; }
+    std::string description() const override { return "Warms the rate up to a high maximum and then anneals it far below its starting value within one cycle."; }
+    std::string formula() const override { return "lr = cos_anneal(lr_max / div, lr_max) during warmup, then cos_anneal(lr_max, lr_max / (div * final_div))"; }
+private:
+    // Cosine interpolation from start to end as progress goes from 0 to 1
+    static double anneal(double start, double end, double progress) {
+        return end + 0.5 * (start - end) * (1.0 + std::cos(kSchedulePi * progress));
+    }
+
+    double max_rate_;
+    long long total_steps_;
+    double warmup_fraction_;
+    double div_factor_;
+    double final_div_factor_;
+};
+
+// Multiplies the rate by factor whenever the reported loss has not improved by more than
+// threshold (relative) for patience epochs, down to min_rate. The rate and loss history are
+// mutable state changed through the const interface, so an instance serves one fit at a time.
+class ReduceOnPlateauScheduler : public LearningRateScheduler {
+public:
+    ReduceOnPlateauScheduler(double initial_rate, double factor = 0.1, int patience = 10,
+                             double min_rate = 0.0, double threshold = 1e-4)
+        : initial_rate_(initial_rate), factor_(factor), patience_(patience), min_rate_(min_rate),
+          threshold_(threshold), rate_(initial_rate) {
+        if (initial_rate <= 0.0) throw std::invalid_argument("Initial rate must be positive.");
+        if (factor <= 0.0 || factor >= 1.0) throw std::invalid_argument("Factor must be in (0, 1).");
+        if (patience < 0) throw std::invalid_argument("Patience cannot be negative.");
+        if (min_rate < 0.0 || threshold < 0.0) throw std::invalid_argument("Minimum rate and threshold cannot be negative.");
+    }
+    using LearningRateScheduler::getRate;
+    double getRate(int /*epoch*/) const override { return rate_; }
+    void reportLoss(double loss, int /*epoch*/) const override {
+        if (loss < best_loss_ * (1.0 - threshold_)) {
+            best_loss_ = loss;
+            bad_epochs_ = 0;
+        } else if (++bad_epochs_ > patience_) {
+            rate_ = std::max(min_rate_, rate_ * factor_);
+            bad_epochs_ = 0;
+        }
+    }
+    void reset() const override {
+        rate_ = initial_rate_;
+        best_loss_ = std::numeric_limits<double>::infinity();
+        bad_epochs_ = 0;
+    }
+    std::string name() const override { return "Reduce On Plateau"; }
+    std::string description() const override { return "Lowers the rate by a constant factor whenever the training loss stops improving."; }
+    std::string formula() const override { return "lr = lr * factor after patience epochs without a relative improvement of threshold"; }
+private:
+    double initial_rate_;
+    double factor_;
+    int patience_;
+    double min_rate_;
+    double threshold_;
+    mutable double rate_;
+    mutable double best_loss_ = std::numeric_limits<double>::infinity();
+    mutable int bad_epochs_ = 0;
+};
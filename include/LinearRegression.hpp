@@ -1,11 +1,24 @@
 #pragma once
 #include <model.hpp>
 #include <Eigen/Dense>
+#include <types.hpp>
 #include <stdexcept>
+#include <memory>
+#include <optional>
 #include <iostream>
 #include <LearningRateScheduler.hpp>
 #include <dataset.hpp>
+#include <sparse_dataset.hpp>
 #include <optimizer.hpp>
+#include <linear_solvers.hpp>
+
+// How LinearRegression::fit finds its weights
+enum class LinearSolver {
+    SGD,       // mini-batch gradient descent through the configured optimizer
+    Cholesky,  // normal equations X^T X + l2 I, accumulated blockwise in parallel (also streams)
+    QR,        // column-pivoted QR of X; in-memory dense data only
+    LBFGS      // L-BFGS on the (ridge) least-squares objective, at most `epochs` iterations
+};
 
 // Linear Regression Model
 // This class implements a simple linear regression model using Eigen for matrix operations.
@@ -14,11 +27,70 @@
 class LinearRegression : public Model
 {
 private:
-    Eigen::VectorXd weights_; // [n_features]
-    double bias_ = 0.0;
+    VectorXs weights_; // [n_features]
+    Scalar bias_ = 0.0;
     double learning_rate_;
     int epochs_;
     int batch_size_;
+    unsigned num_threads_ = 1;
+    ParallelMode parallel_mode_ = ParallelMode::Synchronous;
+    int prefetch_depth_ = 0;
+    std::shared_ptr<GradientDescent> optimizer_;  // null: plain GradientDescent
+    LinearSolver solver_ = LinearSolver::SGD;
+    std::optional<EarlyStopping> early_stopping_;
+    std::optional<Dataset> validation_;
+    double l2_ = 0.0;
+
+    // The configured optimizer, created on first use
+    GradientDescent &get_optimizer() {
+        if (!optimizer_) {
+            optimizer_ = std::make_shared<GradientDescent>(learning_rate_);
+        }
+        optimizer_->set_parallelism(num_threads_, parallel_mode_);
+        optimizer_->set_prefetch(prefetch_depth_);
+        if (early_stopping_) {
+            optimizer_->set_early_stopping(*early_stopping_, validation_ ? &*validation_ : nullptr);
+        }
+        return *optimizer_;
+    }
+
+    // Weights followed by the bias, as returned by the solvers
+    void set_solution(const Eigen::VectorXd &parameters) {
+        weights_ = parameters.head(parameters.size() - 1).cast<Scalar>();
+        bias_ = static_cast<Scalar>(parameters(parameters.size() - 1));
+    }
+
+    // Unnormalized ridge objective ||X w + b - y||^2 + l2 ||w||^2 on one block of rows, with
+    // its gradient added to gradient; X is dense or sparse
+    template <typename Matrix>
+    double add_objective(const Matrix &X, const Eigen::Ref<const VectorXs> &y,
+                         const Eigen::VectorXd &parameters, Eigen::VectorXd &gradient) const {
+        const Eigen::Index d = X.cols();
+        const VectorXs w = parameters.head(d).cast<Scalar>();
+        const Eigen::VectorXd residual = (X * w).template cast<double>().array() + parameters(d) - y.template cast<double>().array();
+        gradient.head(d) += 2.0 * (X.transpose() * residual.cast<Scalar>()).template cast<double>();
+        gradient(d) += 2.0 * residual.sum();
+        return residual.squaredNorm();
+    }
+
+    // L-BFGS on the mean ridge objective; pass(parameters, gradient) returns the summed
+    // objective over all rows and adds the summed gradient
+    template <typename Pass>
+    void fit_lbfgs(int num_features, long long num_rows, Pass &&pass) {
+        Eigen::VectorXd parameters = Eigen::VectorXd::Zero(num_features + 1);
+        LBFGSOptions options;
+        options.max_iterations = epochs_;
+        const int iterations = minimizeLBFGS([&](const Eigen::VectorXd &x, Eigen::VectorXd &gradient) {
+            gradient.setZero(x.size());
+            double objective = pass(x, gradient);
+            objective += l2_ * x.head(num_features).squaredNorm();
+            gradient.head(num_features) += 2.0 * l2_ * x.head(num_features);
+            gradient /= static_cast<double>(num_rows);
+            return objective / num_rows;
+        }, parameters, options);
+        set_solution(parameters);
+        std::cout << "Model trained successfully using L-BFGS (" << iterations << " iterations)." << std::endl;
+    }
 
 public:
     LinearRegression(double lr = 0.001, int epochs = 1000, int batch_size = 32)
@@ -26,15 +98,37 @@ public:
         if (lr <= 0.0) throw std::invalid_argument("Learning rate must be positive.");
         if (epochs <= 0) throw std::invalid_argument("Number of epochs must be positive.");
         if (batch_size <= 0) throw std::invalid_argument("Batch size must be positive.");
-        weights_ = Eigen::VectorXd::Zero(0);
+        weights_ = VectorXs::Zero(0);
     }
 
     void fit(const Dataset &train) override {
-        weights_ = Eigen::VectorXd::Zero(train.getNumFeatures());
+        weights_ = VectorXs::Zero(train.getNumFeatures());
         bias_ = 0.0;
+        if (train.getNumRows() == 0) throw std::runtime_error("Dataset is empty.");
+
+        if (solver_ == LinearSolver::Cholesky) {
+            NormalEquations normal_equations(train.getNumFeatures());
+            normal_equations.add(train.getX(), train.getY(), num_threads_);
+            set_solution(normal_equations.solve(l2_));
+            std::cout << "Model trained successfully using Cholesky." << std::endl;
+            return;
+        }
+        if (solver_ == LinearSolver::QR) {
+            set_solution(solveLeastSquaresQR(train.getX(), train.getY(), l2_));
+            std::cout << "Model trained successfully using QR." << std::endl;
+            return;
+        }
+        if (solver_ == LinearSolver::LBFGS) {
+            const Eigen::Ref<const MatrixXs> X = train.getX();
+            const Eigen::Ref<const VectorXs> y = train.getY();
+            fit_lbfgs(X.cols(), X.rows(), [&](const Eigen::VectorXd &parameters, Eigen::VectorXd &gradient) {
+                return add_objective(X, y, parameters, gradient);
+            });
+            return;
+        }
         
         // Create optimizer and loss function
-        GradientDescent optimizer(learning_rate_);
+        GradientDescent &optimizer = get_optimizer();
         MeanSquaredError loss;
         // Use exponential decay learning rate scheduler with faster decay
         ExponentialDecayLearningRateScheduler scheduler(learning_rate_, 0.01);
@@ -44,37 +138,186 @@ public:
         std::cout << "Model trained successfully using SGD." << std::endl;
     }
 
-    Eigen::VectorXd predict(const Eigen::MatrixXd &X) const override {
+    // Train out-of-core over several passes of a batch stream; batch size comes from the source
+    void fit(BatchSource &source) {
+        weights_ = VectorXs::Zero(source.getNumFeatures());
+        bias_ = 0.0;
+
+        if (solver_ == LinearSolver::QR) {
+            throw std::invalid_argument("The QR solver needs in-memory data; use Cholesky or LBFGS to stream.");
+        }
+        MatrixXs X_batch(source.getBatchSize(), source.getNumFeatures());
+        VectorXs y_batch(source.getBatchSize());
+        if (solver_ == LinearSolver::Cholesky) {
+            // One pass over the stream
+            NormalEquations normal_equations(source.getNumFeatures());
+            source.reset();
+            int rows = 0;
+            while ((rows = source.next(X_batch, y_batch)) > 0) {
+                normal_equations.add(X_batch.topRows(rows), y_batch.head(rows), num_threads_);
+            }
+            set_solution(normal_equations.solve(l2_));
+            std::cout << "Model trained successfully using streamed Cholesky." << std::endl;
+            return;
+        }
+        if (solver_ == LinearSolver::LBFGS) {
+            // Every objective evaluation is one pass over the stream
+            long long num_rows = 0;
+            source.reset();
+            for (int rows = 0; (rows = source.next(X_batch, y_batch)) > 0;) {
+                num_rows += rows;
+            }
+            if (num_rows == 0) throw std::runtime_error("Dataset is empty.");
+            fit_lbfgs(source.getNumFeatures(), num_rows, [&](const Eigen::VectorXd &parameters, Eigen::VectorXd &gradient) {
+                double objective = 0.0;
+                source.reset();
+                for (int rows = 0; (rows = source.next(X_batch, y_batch)) > 0;) {
+                    objective += add_objective(X_batch.topRows(rows), y_batch.head(rows), parameters, gradient);
+                }
+                return objective;
+            });
+            return;
+        }
+
+        GradientDescent &optimizer = get_optimizer();
+        MeanSquaredError loss;
+        ExponentialDecayLearningRateScheduler scheduler(learning_rate_, 0.01);
+
+        optimizer.optimize(*this, source, loss, scheduler, epochs_);
+        std::cout << "Model trained successfully using streamed SGD." << std::endl;
+    }
+
+    // Train on sparse features; predictions and gradients only touch the nonzeros
+    void fit(const SparseDataset &train) {
+        weights_ = VectorXs::Zero(train.getNumFeatures());
+        bias_ = 0.0;
+        if (train.getNumRows() == 0) throw std::runtime_error("Dataset is empty.");
+
+        if (solver_ == LinearSolver::QR) {
+            throw std::invalid_argument("The QR solver needs dense data; use Cholesky or LBFGS for sparse features.");
+        }
+        if (solver_ == LinearSolver::Cholesky) {
+            NormalEquations normal_equations(train.getNumFeatures());
+            normal_equations.add(train.getX(), train.getY());
+            set_solution(normal_equations.solve(l2_));
+            std::cout << "Model trained successfully using sparse Cholesky." << std::endl;
+            return;
+        }
+        if (solver_ == LinearSolver::LBFGS) {
+            fit_lbfgs(train.getNumFeatures(), train.getNumRows(), [&](const Eigen::VectorXd &parameters, Eigen::VectorXd &gradient) {
+                return add_objective(train.getX(), train.getY(), parameters, gradient);
+            });
+            return;
+        }
+
+        GradientDescent &optimizer = get_optimizer();
+        MeanSquaredError loss;
+        ExponentialDecayLearningRateScheduler scheduler(learning_rate_, 0.01);
+
+        optimizer.optimize(*this, train, loss, scheduler, epochs_, batch_size_);
+        std::cout << "Model trained successfully using sparse SGD." << std::endl;
+    }
+
+    // Choose how fit() solves for the weights. l2 is the ridge penalty on the weights (not the
+    // bias) used by the Cholesky, QR and LBFGS solvers; SGD ignores it.
+    void set_solver(LinearSolver solver, double l2 = 0.0) {
+        if (l2 < 0.0) throw std::invalid_argument("L2 penalty cannot be negative.");
+        solver_ = solver;
+        l2_ = l2;
+    }
+    LinearSolver get_solver() const { return solver_; }
+    double get_l2() const { return l2_; }
+
+    // Train with another gradient-based optimizer (Momentum, Nesterov, AdaGrad, RMSProp, Adam);
+    // the learning rate still comes from the model's scheduler
+    void set_optimizer(std::shared_ptr<GradientDescent> optimizer) {
+        if (!optimizer) throw std::invalid_argument("Optimizer cannot be null.");
+        num_threads_ = optimizer->get_num_threads();
+        parallel_mode_ = optimizer->get_parallel_mode();
+        prefetch_depth_ = optimizer->get_prefetch();
+        optimizer_ = std::move(optimizer);
+    }
+
+    // Stop SGD training once the loss stops improving; see GradientDescent::set_early_stopping.
+    // Only the SGD solver runs epochs, the direct solvers ignore this.
+    void set_early_stopping(const EarlyStopping &early_stopping, const Dataset *validation = nullptr) {
+        early_stopping.validate();
+        early_stopping_ = early_stopping;
+        if (validation) {
+            validation_ = *validation;
+        } else {
+            validation_.reset();
+        }
+    }
+
+    // Threads used by fit(const Dataset&) and by the Cholesky solver's X^T X accumulation;
+    // see GradientDescent::set_parallelism
+    void set_parallelism(unsigned num_threads, ParallelMode mode = ParallelMode::Synchronous) {
+        num_threads_ = resolveThreadCount(num_threads);
+        parallel_mode_ = mode;
+    }
+
+    // Batches prepared ahead on a background thread by the SGD solver; see GradientDescent::set_prefetch
+    void set_prefetch(int depth) {
+        if (depth < 0) throw std::invalid_argument("Prefetch depth cannot be negative.");
+        prefetch_depth_ = depth;
+    }
+
+    VectorXs predict(const MatrixXs &X) const override {
+        if (weights_.size() == 0) throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
+        return X * weights_ + VectorXs::Constant(X.rows(), bias_);
+    }
+
+    VectorXs predict_sparse(const Eigen::Ref<const SparseMatrixXs> &X) const override {
         if (weights_.size() == 0) throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
-        return X * weights_ + Eigen::VectorXd::Constant(X.rows(), bias_);
+        return (X * weights_).array() + bias_;
     }
 
-    void update_parameters(Eigen::VectorXd gradients, double rate) override {
+    void predict_into(const Eigen::Ref<const MatrixXs> &X, Eigen::Ref<VectorXs> out) const override {
+        if (weights_.size() == 0) throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
+        out.noalias() = X * weights_;
+        out.array() += bias_;
+    }
+
+    void predict_sparse_into(const Eigen::Ref<const SparseMatrixXs> &X, Eigen::Ref<VectorXs> out) const override {
+        if (weights_.size() == 0) throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
+        out.noalias() = X * weights_;
+        out.array() += bias_;
+    }
+
+    void update_parameters(const VectorXs &gradients, double rate) override {
         if (weights_.size() == 0) throw std::runtime_error("Model has not been trained yet. Call fit() before update_parameters().");
         
-        // Split gradients into weights and bias updates
-        // The last element of gradients is for bias
-        Eigen::VectorXd weight_gradients = gradients.head(weights_.size());
-        double bias_gradient = gradients.tail(1)(0);
-        
-        // Update parameters with bounds to prevent explosion
-        weights_ -= rate * weight_gradients;
-        bias_ -= rate * bias_gradient;
+        // The last element of gradients is for bias; update parameters in place
+        weights_.noalias() -= rate * gradients.head(weights_.size());
+        bias_ -= rate * gradients(weights_.size());
         
         // Clip weights to prevent explosion
-        double max_weight = 10.0;
+        Scalar max_weight = 10.0;
         weights_ = weights_.cwiseMax(-max_weight).cwiseMin(max_weight);
         
         // Clip bias to prevent explosion
-        double max_bias = 10.0;
+        Scalar max_bias = 10.0;
         bias_ = std::max(-max_bias, std::min(max_bias, bias_));
     }
 
+    VectorXs get_parameters() const override {
+        VectorXs parameters(weights_.size() + 1);
+        parameters << weights_, bias_;
+        return parameters;
+    }
+
+    void set_parameters(const VectorXs &parameters) override {
+        if (parameters.size() == 0) throw std::invalid_argument("Parameters cannot be empty.");
+        weights_ = parameters.head(parameters.size() - 1);
+        bias_ = parameters(parameters.size() - 1);
+    }
+
     std::string name() const override { return "Linear Regression"; }
     std::string description() const override { return "A simple linear regression model."; }
     std::string formula() const override { return "y = Xw + b"; }
     std::string gradient_formula() const override { return "∇L = -2/n * X^T(y - Xw)"; }
-    Eigen::VectorXd get_weights() const { return weights_; }
-    double get_bias() const { return bias_; }
+    VectorXs get_weights() const { return weights_; }
+    Scalar get_bias() const { return bias_; }
     ~LinearRegression() override = default;
 };
@@ -1,29 +1,208 @@
 #pragma once
 #include <model.hpp>
 #include <Eigen/Dense>
+#include <types.hpp>
 #include <stdexcept>
+#include <optional>
+#include <memory>
+#include <algorithm>
 #include <iostream>
 #include <LearningRateScheduler.hpp>
 #include <dataset.hpp>
+#include <sparse_dataset.hpp>
 #include <optimizer.hpp>
+#include <linear_solvers.hpp>
+#include <parallel.hpp>
+
+// How LogisticRegression::fit minimizes the log loss
+enum class LogisticSolver {
+    SGD,       // mini-batch gradient descent through GradientDescent
+    Newton,    // Newton's method as iteratively reweighted least squares: X^T S X is formed blockwise and solved by Cholesky
+    NewtonCG   // Newton steps solved by conjugate gradient with Hessian-vector products, never forming X^T S X
+};
 
 class LogisticRegression : public Model
 {
 private:
-    Eigen::VectorXd weights_;
-    Eigen::VectorXd bias_;
+    VectorXs weights_;
+    VectorXs bias_;
     double lr_{};
     int epochs_{};
     int batch_size_{};
+    unsigned num_threads_ = 1;
+    ParallelMode parallel_mode_ = ParallelMode::Synchronous;
+    int prefetch_depth_ = 0;
+    std::shared_ptr<GradientDescent> optimizer_;  // null: plain GradientDescent
+    LogisticSolver solver_ = LogisticSolver::SGD;
+    double l2_ = 0.0;
+    std::optional<EarlyStopping> early_stopping_;
+    std::optional<Dataset> validation_;
+
+    // Newton iterations stop once the gradient of the mean loss is this small
+    static constexpr double kNewtonTolerance = 1e-8;
+    // Lower bound on the IRLS row weights p (1 - p), which vanish for saturated rows
+    static constexpr double kMinRowWeight = 1e-10;
+
+    // The configured optimizer, created on first use
+    GradientDescent &get_optimizer() {
+        if (!optimizer_) {
+            optimizer_ = std::make_shared<GradientDescent>(lr_);
+        }
+        optimizer_->set_parallelism(num_threads_, parallel_mode_);
+        optimizer_->set_prefetch(prefetch_depth_);
+        if (early_stopping_) {
+            optimizer_->set_early_stopping(*early_stopping_, validation_ ? &*validation_ : nullptr);
+        }
+        return *optimizer_;
+    }
+
+    // Penalized log loss sum_i [log(1 + exp(z_i)) - y_i z_i] + (l2 / 2) ||w||^2 at
+    // theta = (w, b), with the scores z = X w + b and the probabilities written out.
+    // log(1 + exp(z)) is evaluated as max(z, 0) + log1p(exp(-|z|)) so it cannot overflow.
+    template <typename Matrix>
+    double log_loss(const Matrix &X, const Eigen::Ref<const VectorXs> &y, const Eigen::VectorXd &theta,
+                    Eigen::VectorXd &z, Eigen::VectorXd &p) const {
+        const Eigen::Index d = X.cols();
+        const VectorXs w = theta.head(d).cast<Scalar>();
+        z = (X * w).template cast<double>().array() + theta(d);
+        p = (1.0 + (-z.array()).exp()).inverse();
+        const Eigen::ArrayXd softplus = z.array().max(0.0) + (-z.array().abs()).exp().log1p();
+        return (softplus - y.template cast<double>().array() * z.array()).sum() + 0.5 * l2_ * theta.head(d).squaredNorm();
+    }
+
+    // (X^T S X + l2 I) v for S = diag(row_weights), with X extended by a column of ones and the
+    // bias left unpenalized. Rows are split into one range per thread and summed in thread order.
+    template <typename Matrix>
+    Eigen::VectorXd hessian_product(const Matrix &X, const Eigen::VectorXd &row_weights, const Eigen::VectorXd &v) const {
+        const Eigen::Index d = X.cols();
+        const VectorXs v_w = v.head(d).cast<Scalar>();
+        const unsigned num_threads = std::min<unsigned>(num_threads_, std::max<Eigen::Index>(1, X.rows() / 256));
+        std::vector<Eigen::VectorXd> partial(num_threads, Eigen::VectorXd::Zero(d + 1));
+        parallelFor(0, X.rows(), num_threads, [&](size_t begin, size_t end, unsigned t) {
+            const auto rows = X.middleRows(begin, end - begin);
+            const Eigen::VectorXd u = ((rows * v_w).template cast<double>().array() + v(d)) * row_weights.segment(begin, end - begin).array();
+            partial[t].head(d) = (rows.transpose() * u.cast<Scalar>()).template cast<double>();
+            partial[t](d) = u.sum();
+        });
+        Eigen::VectorXd result = Eigen::VectorXd::Zero(d + 1);
+        for (const auto &sum : partial) {
+            result += sum;
+        }
+        result.head(d) += l2_ * v.head(d);
+        return result;
+    }
+
+    // Solve H x = b approximately by conjugate gradient, stopping at a relative residual of
+    // min(0.5, sqrt(||b||)) (a truncated Newton forcing term) or after d + 1 iterations
+    template <typename Matrix>
+    Eigen::VectorXd conjugate_gradient(const Matrix &X, const Eigen::VectorXd &row_weights, const Eigen::VectorXd &b) const {
+        Eigen::VectorXd x = Eigen::VectorXd::Zero(b.size());
+        Eigen::VectorXd r = b;
+        Eigen::VectorXd direction = r;
+        double residual = r.squaredNorm();
+        const double target = std::pow(std::min(0.5, std::sqrt(b.norm())) * b.norm(), 2);
+        for (Eigen::Index k = 0; k < b.size() && residual > target; ++k) {
+            const Eigen::VectorXd Hd = hessian_product(X, row_weights, direction);
+            const double curvature = direction.dot(Hd);
+            if (curvature <= 0) {
+                break;
+            }
+            const double alpha = residual / curvature;
+            x += alpha * direction;
+            r -= alpha * Hd;
+            const double next_residual = r.squaredNorm();
+            direction = r + (next_residual / residual) * direction;
+            residual = next_residual;
+        }
+        return x;
+    }
+
+    // Damped Newton iterations from theta = 0; X is dense or sparse. Each step solves
+    // H step = -gradient, exactly (Newton: IRLS normal equations) or by CG (NewtonCG), and is
+    // halved until the loss decreases enough (Armijo). epochs_ bounds the number of iterations.
+    template <typename Matrix>
+    void fit_newton(const Matrix &X, const Eigen::Ref<const VectorXs> &y) {
+        const Eigen::Index n = X.rows();
+        const Eigen::Index d = X.cols();
+        const Eigen::VectorXd y_d = y.template cast<double>();
+        Eigen::VectorXd theta = Eigen::VectorXd::Zero(d + 1);
+        Eigen::VectorXd z, p, z_new, p_new;
+        double loss = log_loss(X, y, theta, z, p);
 
+        int iteration = 0;
+        for (; iteration < epochs_; ++iteration) {
+            const Eigen::VectorXd residual = p - y_d;
+            Eigen::VectorXd gradient(d + 1);
+            gradient.head(d) = (X.transpose() * residual.cast<Scalar>()).template cast<double>() + l2_ * theta.head(d);
+            gradient(d) = residual.sum();
+            if (gradient.norm() <= kNewtonTolerance * n) {
+                break;
+            }
+
+            const Eigen::VectorXd row_weights = (p.array() * (1.0 - p.array())).max(kMinRowWeight).matrix();
+            Eigen::VectorXd step;
+            if (solver_ == LogisticSolver::Newton) {
+                // Weighted least squares on the working response z + (y - p) / s gives the Newton iterate
+                const Eigen::VectorXd working = z - residual.cwiseQuotient(row_weights);
+                NormalEquations normal_equations(d);
+                add_rows(normal_equations, X, working.cast<Scalar>(), row_weights);
+                step = normal_equations.solve(l2_) - theta;
+            } else {
+                step = conjugate_gradient(X, row_weights, -gradient);
+            }
+            double slope = gradient.dot(step);
+            if (!(slope < 0)) {
+                step = -gradient;
+                slope = -gradient.squaredNorm();
+            }
+
+            // Backtrack until Armijo holds; z_new and p_new then belong to theta + rate * step
+            double rate = 1.0;
+            double loss_new = loss;
+            bool accepted = false;
+            for (int trial = 0; trial < 30; ++trial) {
+                loss_new = log_loss(X, y, theta + rate * step, z_new, p_new);
+                if (std::isfinite(loss_new) && loss_new <= loss + 1e-4 * rate * slope) {
+                    accepted = true;
+                    break;
+                }
+                rate *= 0.5;
+            }
+            if (!accepted) {
+                break;
+            }
+            theta += rate * step;
+            z.swap(z_new);
+            p.swap(p_new);
+            const double change = loss - loss_new;
+            loss = loss_new;
+            if (change <= kNewtonTolerance * std::max(1.0, loss)) {
+                ++iteration;
+                break;
+            }
+        }
+        weights_ = theta.head(d).cast<Scalar>();
+        bias_ = VectorXs::Constant(1, static_cast<Scalar>(theta(d)));
+        std::cout << "Model trained successfully using " << (solver_ == LogisticSolver::Newton ? "Newton" : "Newton-CG")
+                  << " (" << iteration << " iterations)." << std::endl;
+    }
+
+    void add_rows(NormalEquations &normal_equations, const Eigen::Ref<const MatrixXs> &X,
+                  const VectorXs &target, const Eigen::VectorXd &row_weights) const {
+        normal_equations.add(X, target, row_weights, num_threads_);
+    }
+    void add_rows(NormalEquations &normal_equations, const SparseMatrixXs &X,
+                  const VectorXs &target, const Eigen::VectorXd &row_weights) const {
+        normal_equations.add(X, target, row_weights);
+    }
 
     // Sigmoid function
-    static double sigmoid(double z) {
+    static Scalar sigmoid(Scalar z) {
         return 1.0 / (1.0 + std::exp(-z));
     }
 
     // Sigmoid function for vector
-    static Eigen::VectorXd sigmoid(const Eigen::VectorXd &z) {
+    static VectorXs sigmoid(const VectorXs &z) {
         return (1.0 + (-z.array()).exp()).inverse();
     }
 
@@ -35,57 +214,165 @@ public:
             throw std::invalid_argument("Number of epochs must be positive.");
         if (batch_size <= 0)
             throw std::invalid_argument("Batch size must be positive.");
-        weights_ = Eigen::VectorXd::Zero(0);
+        weights_ = VectorXs::Zero(0);
     }
 
 
 
+    // Mini-batch training of the binary cross entropy through GradientDescent (or the optimizer
+    // given to set_optimizer), with the learning rate held constant
     void fit(const Dataset &train) override{
-        weights_ = Eigen::VectorXd::Zero(train.getNumFeatures());
-        bias_ = Eigen::VectorXd::Zero(1);
-        Eigen::MatrixXd X = train.getX();
-        Eigen::VectorXd y = train.getY();
-        if (X.rows() == 0 || X.cols() == 0)
+        weights_ = VectorXs::Zero(train.getNumFeatures());
+        bias_ = VectorXs::Zero(1);
+        if (train.getNumRows() == 0 || train.getNumFeatures() == 0)
             throw std::runtime_error("Training data is empty.");
-        if (y.size() != X.rows())
-            throw std::runtime_error("Mismatch between number of samples in X and y.");
-        for (int epoch = 0; epoch < epochs_; ++epoch) {
-            for (int i = 0; i < X.rows(); i += batch_size_) {
-                auto z = weights_.dot(X.row(i).transpose()) + bias_(0);
-                auto prediction = sigmoid(z);
-                auto error = prediction - y(i);
-                
-                // Update weights and bias
-                weights_ -= lr_ * error * X.row(i).transpose();
-                bias_ -= lr_ * Eigen::VectorXd::Constant(1, error);
-            }
+        if (solver_ != LogisticSolver::SGD) {
+            fit_newton(train.getX(), train.getY());
+            return;
         }
+        BinaryCrossEntropyWithLogits loss;
+        ConstantLearningRateScheduler scheduler(lr_);
+        get_optimizer().optimize(*this, train, loss, scheduler, epochs_, std::min(batch_size_, train.getNumRows()));
         std::cout << "Model trained successfully." << std::endl;
     }
 
-    void update_parameters(Eigen::VectorXd gradients, double rate) override {
+    // Same training on sparse rows: predictions and gradients only touch the nonzeros
+    void fit(const SparseDataset &train) {
+        weights_ = VectorXs::Zero(train.getNumFeatures());
+        bias_ = VectorXs::Zero(1);
+        if (train.getNumRows() == 0 || train.getNumFeatures() == 0)
+            throw std::runtime_error("Training data is empty.");
+        if (solver_ != LogisticSolver::SGD) {
+            fit_newton(train.getX(), train.getY());
+            return;
+        }
+        BinaryCrossEntropyWithLogits loss;
+        ConstantLearningRateScheduler scheduler(lr_);
+        get_optimizer().optimize(*this, train, loss, scheduler, epochs_, std::min(batch_size_, train.getNumRows()));
+        std::cout << "Model trained successfully." << std::endl;
+    }
+
+    // Choose how fit() minimizes the log loss. l2 is the ridge penalty (l2 / 2) ||w||^2 on the
+    // weights (not the bias) used by the Newton solvers; SGD ignores it. With the Newton
+    // solvers epochs bounds the number of Newton iterations.
+    void set_solver(LogisticSolver solver, double l2 = 0.0) {
+        if (l2 < 0.0)
+            throw std::invalid_argument("L2 penalty cannot be negative.");
+        solver_ = solver;
+        l2_ = l2;
+    }
+    LogisticSolver get_solver() const { return solver_; }
+    double get_l2() const { return l2_; }
+
+    // Threads used by SGD (see GradientDescent::set_parallelism) and by the Newton solvers'
+    // Hessian accumulation and Hessian-vector products
+    void set_parallelism(unsigned num_threads, ParallelMode mode = ParallelMode::Synchronous) {
+        num_threads_ = resolveThreadCount(num_threads);
+        parallel_mode_ = mode;
+    }
+
+    // Batches prepared ahead on a background thread by the SGD solver; see GradientDescent::set_prefetch
+    void set_prefetch(int depth)
+    {
+        if (depth < 0)
+            throw std::invalid_argument("Prefetch depth cannot be negative.");
+        prefetch_depth_ = depth;
+    }
+
+    // Training runs on the logits z = X w + b, paired with BinaryCrossEntropyWithLogits, so the
+    // parameter gradient is the default linear one; predict() still returns probabilities
+    void forward(const Eigen::Ref<const MatrixXs> &X, Eigen::Ref<VectorXs> out) const override
+    {
+        if (weights_.size() == 0)
+            throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
+        out.noalias() = X * weights_;
+        out.array() += bias_(0);
+    }
+
+    void forward_sparse(const Eigen::Ref<const SparseMatrixXs> &X, Eigen::Ref<VectorXs> out) const override
+    {
+        if (weights_.size() == 0)
+            throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
+        out.noalias() = X * weights_;
+        out.array() += bias_(0);
+    }
+
+    void update_parameters(const VectorXs &gradients, double rate) override {
         if (weights_.size() == 0)
             throw std::runtime_error("Model has not been trained yet. Call fit() before update_parameters().");
         
-        // Split gradients into weights and bias updates
-        Eigen::VectorXd weight_gradients = gradients.head(weights_.size());
-        double bias_gradient = gradients.tail(1)(0);
-        
-        // Update parameters with bounds to prevent explosion
-        weights_ -= rate * weight_gradients;
-        bias_(0) -= rate * bias_gradient;   
-
+        // Weights first, bias last; update in place
+        weights_.noalias() -= rate * gradients.head(weights_.size());
+        bias_(0) -= rate * gradients(weights_.size());
+    }
 
+    VectorXs predict(const MatrixXs &X) const override // returns P(class=1)
+    {
+        if (weights_.size() == 0)
+            throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
+        VectorXs z = X * weights_ + bias_.replicate(X.rows(), 1);
+        return sigmoid(z);
     }
 
-    Eigen::VectorXd predict(const Eigen::MatrixXd &X) const override // returns P(class=1)
+    VectorXs predict_sparse(const Eigen::Ref<const SparseMatrixXs> &X) const override
     {
         if (weights_.size() == 0)
             throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
-        Eigen::VectorXd z = X * weights_ + bias_.replicate(X.rows(), 1);
+        VectorXs z = (X * weights_).array() + bias_(0);
         return sigmoid(z);
     }
 
+    void predict_into(const Eigen::Ref<const MatrixXs> &X, Eigen::Ref<VectorXs> out) const override
+    {
+        if (weights_.size() == 0)
+            throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
+        out.noalias() = X * weights_;
+        out = (1.0 + (-(out.array() + bias_(0))).exp()).inverse();
+    }
+
+    void predict_sparse_into(const Eigen::Ref<const SparseMatrixXs> &X, Eigen::Ref<VectorXs> out) const override
+    {
+        if (weights_.size() == 0)
+            throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
+        out.noalias() = X * weights_;
+        out = (1.0 + (-(out.array() + bias_(0))).exp()).inverse();
+    }
+
+    VectorXs get_parameters() const override {
+        VectorXs parameters(weights_.size() + 1);
+        parameters << weights_, bias_(0);
+        return parameters;
+    }
+
+    void set_parameters(const VectorXs &parameters) override {
+        if (parameters.size() == 0)
+            throw std::invalid_argument("Parameters cannot be empty.");
+        weights_ = parameters.head(parameters.size() - 1);
+        bias_ = parameters.tail(1);
+    }
+
+    // Train with another gradient-based optimizer (Momentum, Nesterov, AdaGrad, RMSProp, Adam);
+    // the learning rate is the model's
+    void set_optimizer(std::shared_ptr<GradientDescent> optimizer) {
+        if (!optimizer)
+            throw std::invalid_argument("Optimizer cannot be null.");
+        num_threads_ = optimizer->get_num_threads();
+        parallel_mode_ = optimizer->get_parallel_mode();
+        prefetch_depth_ = optimizer->get_prefetch();
+        optimizer_ = std::move(optimizer);
+    }
+
+    // Stop training once the binary cross entropy (on validation if given, otherwise on the
+    // training set) has not improved for patience epochs; see GradientDescent::set_early_stopping
+    void set_early_stopping(const EarlyStopping &early_stopping, const Dataset *validation = nullptr) {
+        early_stopping.validate();
+        early_stopping_ = early_stopping;
+        if (validation)
+            validation_ = *validation;
+        else
+            validation_.reset();
+    }
+
     std::string name() const override {
         return "Logistic Regression";
     }
@@ -102,10 +389,10 @@ public:
         return "∂L/∂w = (P(y=1|X) - y) * X, ∂L/∂b = P(y=1|X) - y";
     }
     
-    Eigen::VectorXd get_weights() const {
+    VectorXs get_weights() const {
         return weights_;
     }   
-    Eigen::VectorXd get_bias() const {
+    VectorXs get_bias() const {
         return bias_;
     }
     double get_learning_rate() const {
@@ -1,17 +1,78 @@
 #pragma once
 #include "model.hpp"
 #include <Eigen/Dense>
+#include "types.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <random>
+#include <algorithm>
 #include "LearningRateScheduler.hpp"
 #include "dataset.hpp"
 
+// How PCA::fit finds the components
+enum class PCASolver {
+    Auto,       // Randomized when the number of components is small next to the number of features, Full otherwise
+    Full,       // eigendecomposition of the full d x d covariance: O(n d^2 + d^3)
+    Randomized  // randomized range finder with power iterations, top components only: O(n d k)
+};
+
 class PCA : public Model {
     private:
-        Eigen::MatrixXd _components;
-        Eigen::VectorXd _explained_variance;
-        Eigen::VectorXd _explained_variance_ratio;
+        MatrixXs _components;
+        VectorXs _explained_variance;
+        VectorXs _explained_variance_ratio;
         int _n_components;
+        PCASolver _solver = PCASolver::Auto;
+        int _n_oversamples = 10;
+        int _n_power_iterations = 4;
+        unsigned int _seed = 0;
+
+        // Auto picks the randomized solver from this many features on, when the sketch
+        // (components + oversamples) is at most a quarter of them
+        static constexpr int kRandomizedMinFeatures = 500;
+
+        bool use_randomized(Eigen::Index rows, Eigen::Index cols) const {
+            if (_solver != PCASolver::Auto) {
+                return _solver == PCASolver::Randomized;
+            }
+            const Eigen::Index sketch = _n_components + _n_oversamples;
+            return cols >= kRandomizedMinFeatures && 4 * sketch <= cols && sketch <= rows;
+        }
+
+        // Orthonormal basis of the columns of Y (thin Householder QR)
+        static MatrixXs orthonormalize(const MatrixXs &Y) {
+            Eigen::HouseholderQR<MatrixXs> qr(Y);
+            return qr.householderQ() * MatrixXs::Identity(Y.rows(), Y.cols());
+        }
+
+        // Halko, Martinsson & Tropp: sample the range of the centered data with a Gaussian test
+        // matrix of k + oversamples columns, sharpen it with power iterations (re-orthonormalized
+        // every half step so small singular values are not lost to rounding), then take the
+        // exact SVD of the small projection Q^T A. Writes the top right singular vectors and
+        // singular values.
+        void randomized_svd(const MatrixXs &centered, MatrixXs &components, VectorXs &singular_values) const {
+            const Eigen::Index sketch = std::min<Eigen::Index>(_n_components + _n_oversamples,
+                                                               std::min(centered.rows(), centered.cols()));
+            if (sketch < _n_components) {
+                throw std::invalid_argument("Randomized PCA needs at least as many samples as components");
+            }
+            std::mt19937 rng(_seed);
+            std::normal_distribution<double> gaussian(0.0, 1.0);
+            MatrixXs omega(centered.cols(), sketch);
+            for (Eigen::Index i = 0; i < omega.size(); ++i) {
+                omega.data()[i] = static_cast<Scalar>(gaussian(rng));
+            }
+
+            MatrixXs Q = orthonormalize(centered * omega);
+            for (int i = 0; i < _n_power_iterations; ++i) {
+                Q = orthonormalize(centered * orthonormalize(centered.transpose() * Q));
+            }
+
+            const MatrixXs B = Q.transpose() * centered;  // sketch x d
+            Eigen::BDCSVD<MatrixXs> svd(B, Eigen::ComputeThinV);
+            components = svd.matrixV().leftCols(_n_components);
+            singular_values = svd.singularValues().head(_n_components);
+        }
 
     public:
         PCA(int n_components = 2) : _n_components(n_components) {
@@ -20,8 +81,25 @@ class PCA : public Model {
             }
         }
 
+        // Choose the solver. The randomized solver samples n_components + n_oversamples
+        // directions and refines them with n_power_iterations passes over the data; more passes
+        // give more accurate components when the spectrum decays slowly. seed fixes the sample.
+        void set_solver(PCASolver solver, int n_oversamples = 10, int n_power_iterations = 4, unsigned int seed = 0) {
+            if (n_oversamples < 0 || n_power_iterations < 0) {
+                throw std::invalid_argument("Oversamples and power iterations cannot be negative");
+            }
+            _solver = solver;
+            _n_oversamples = n_oversamples;
+            _n_power_iterations = n_power_iterations;
+            _seed = seed;
+        }
+
+        PCASolver get_solver() const {
+            return _solver;
+        }
+
         void fit(const Dataset &train) override {
-            Eigen::MatrixXd X = train.getX();
+            const Eigen::Ref<const MatrixXs> X = train.getX();
             if (X.rows() == 0 || X.cols() == 0) {
                 throw std::invalid_argument("Input matrix cannot be empty");
             }
@@ -30,17 +108,27 @@ class PCA : public Model {
             }
 
             // Center the data
-            Eigen::MatrixXd centered = X.rowwise() - X.colwise().mean();
+            MatrixXs centered = X.rowwise() - X.colwise().mean();
+
+            if (use_randomized(X.rows(), X.cols())) {
+                VectorXs singular_values;
+                randomized_svd(centered, _components, singular_values);
+                // The total variance is the trace of the covariance, no decomposition needed
+                const double total_variance = centered.squaredNorm() / (X.rows() - 1);
+                _explained_variance = singular_values.array().square() / (X.rows() - 1);
+                _explained_variance_ratio = _explained_variance.array() / total_variance;
+                return;
+            }
             
             // Compute covariance matrix
-            Eigen::MatrixXd cov = centered.transpose() * centered / (X.rows() - 1);
+            MatrixXs cov = centered.transpose() * centered / (X.rows() - 1);
             
             // Compute eigendecomposition
-            Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig(cov);
+            Eigen::SelfAdjointEigenSolver<MatrixXs> eig(cov);
             
             // Sort eigenvalues and eigenvectors in descending order
-            Eigen::VectorXd eigenvalues = eig.eigenvalues().reverse();
-            Eigen::MatrixXd eigenvectors = eig.eigenvectors().rowwise().reverse();
+            VectorXs eigenvalues = eig.eigenvalues().reverse();
+            MatrixXs eigenvectors = eig.eigenvectors().rowwise().reverse();
             
             // Store results
             _components = eigenvectors.leftCols(_n_components);
@@ -48,16 +136,16 @@ class PCA : public Model {
             _explained_variance_ratio = _explained_variance.array() / eigenvalues.sum();
         }
 
-        Eigen::VectorXd predict(const Eigen::MatrixXd &X) const override {
+        VectorXs predict(const MatrixXs &X) const override {
             // For PCA, predict is the same as transform
             return transform(X).rowwise().norm();
         }
 
-        void update_parameters(Eigen::VectorXd gradients, double rate) override {
+        void update_parameters(const VectorXs &gradients, double rate) override {
             throw std::logic_error("PCA does not support parameter updates");
         }
 
-        Eigen::MatrixXd transform(const Eigen::MatrixXd &X) const {
+        MatrixXs transform(const MatrixXs &X) const {
             if (X.rows() == 0 || X.cols() == 0) {
                 throw std::invalid_argument("Input matrix cannot be empty");
             }
@@ -67,7 +155,7 @@ class PCA : public Model {
             return X * _components;
         }
 
-        Eigen::MatrixXd inverse_transform(const Eigen::MatrixXd &X) const {
+        MatrixXs inverse_transform(const MatrixXs &X) const {
             if (X.rows() == 0 || X.cols() == 0) {
                 throw std::invalid_argument("Input matrix cannot be empty");
             }
@@ -77,15 +165,15 @@ class PCA : public Model {
             return X * _components.transpose();
         }
 
-        Eigen::MatrixXd get_components() const {
+        MatrixXs get_components() const {
             return _components;
         }
 
-        Eigen::VectorXd get_explained_variance() const {
+        VectorXs get_explained_variance() const {
             return _explained_variance;
         }
 
-        Eigen::VectorXd get_explained_variance_ratio() const {
+        VectorXs get_explained_variance_ratio() const {
             return _explained_variance_ratio;
         }
 
@@ -0,0 +1,201 @@
+#pragma once
+#include <model.hpp>
+#include <Eigen/Dense>
+#include <types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include <iostream>
+#include <dataset.hpp>
+#include <loss.hpp>
+
+// Multinomial logistic (softmax) regression: one weight column and one bias per class, trained
+// with mini-batch gradient descent on the cross entropy. Targets are class labels 0..K-1.
+// The logits of a whole batch come from one matrix product W^T X^T, and the softmax, loss and
+// logit gradient are fused in softmaxCrossEntropy; the weight gradient is a second product.
+class SoftmaxRegression : public Model
+{
+private:
+    MatrixXs weights_;  // [n_features x n_classes]
+    VectorXs bias_;     // [n_classes]
+    double lr_{};
+    int epochs_{};
+    int batch_size_{};
+    int num_classes_{};  // 0: one more than the largest label seen by fit()
+
+    // Labels must be whole numbers in [0, num_classes)
+    static int count_classes(const Eigen::Ref<const VectorXs> &y, int num_classes) {
+        Scalar largest = 0;
+        for (Eigen::Index i = 0; i < y.size(); ++i) {
+            if (y(i) < 0 || y(i) != std::floor(y(i)))
+                throw std::invalid_argument("Softmax regression targets must be class labels 0, 1, 2, ...");
+            largest = std::max(largest, y(i));
+        }
+        if (num_classes == 0)
+            return static_cast<int>(largest) + 1;
+        if (largest >= num_classes)
+            throw std::invalid_argument("Target label is not below the number of classes.");
+        return num_classes;
+    }
+
+    void check_fitted(Eigen::Index cols) const {
+        if (weights_.size() == 0)
+            throw std::runtime_error("Model has not been trained yet. Call fit() before predict().");
+        if (cols != weights_.rows())
+            throw std::invalid_argument("Number of columns does not match the trained model.");
+    }
+
+public:
+    SoftmaxRegression(double lr = 0.1, int epochs = 100, int batch_size = 32, int num_classes = 0)
+        : lr_{lr}, epochs_{epochs}, batch_size_{batch_size}, num_classes_{num_classes} {
+        if (lr <= 0.0)
+            throw std::invalid_argument("Learning rate must be positive.");
+        if (epochs <= 0)
+            throw std::invalid_argument("Number of epochs must be positive.");
+        if (batch_size <= 0)
+            throw std::invalid_argument("Batch size must be positive.");
+        if (num_classes < 0 || num_classes == 1)
+            throw std::invalid_argument("Number of classes must be at least 2 (or 0 to infer it).");
+    }
+
+    void fit(const Dataset &train) override {
+        const Eigen::Ref<const MatrixXs> X = train.getX();
+        const Eigen::Ref<const VectorXs> y = train.getY();
+        if (X.rows() == 0 || X.cols() == 0)
+            throw std::runtime_error("Training data is empty.");
+        const int num_classes = count_classes(y, num_classes_);
+        const int num_samples = X.rows();
+        const int num_features = X.cols();
+        const int batch_size = std::min(batch_size_, num_samples);
+        weights_ = MatrixXs::Zero(num_features, num_classes);
+        bias_ = VectorXs::Zero(num_classes);
+
+        // Buffers reused by every batch
+        std::vector<int> order(num_samples);
+        MatrixXs X_batch(batch_size, num_features);
+        VectorXs y_batch(batch_size);
+        MatrixXs logits(num_classes, batch_size);  // one column per row of the batch
+        MatrixXs weight_gradients(num_features, num_classes);
+
+        for (int epoch = 0; epoch < epochs_; ++epoch) {
+            std::iota(order.begin(), order.end(), 0);
+            std::shuffle(order.begin(), order.end(), std::default_random_engine(epoch));
+            double epoch_loss = 0.0;
+            for (int start = 0; start < num_samples; start += batch_size) {
+                const int rows = std::min(batch_size, num_samples - start);
+                for (int j = 0; j < num_features; ++j) {
+                    for (int r = 0; r < rows; ++r) {
+                        X_batch(r, j) = X(order[start + r], j);
+                    }
+                }
+                for (int r = 0; r < rows; ++r) {
+                    y_batch(r) = y(order[start + r]);
+                }
+                const auto X_rows = X_batch.topRows(rows);
+                auto batch_logits = logits.leftCols(rows);
+
+                batch_logits.noalias() = weights_.transpose() * X_rows.transpose();
+                batch_logits.colwise() += bias_;
+                epoch_loss += softmaxCrossEntropy(batch_logits, y_batch.head(rows)) * rows / num_samples;
+
+                weight_gradients.noalias() = X_rows.transpose() * batch_logits.transpose();
+                weights_.noalias() -= lr_ * weight_gradients;
+                bias_.noalias() -= lr_ * batch_logits.rowwise().sum();
+            }
+            std::cout << "Epoch " << epoch + 1 << "/" << epochs_ << ": Loss = " << epoch_loss << std::endl;
+        }
+        std::cout << "Model trained successfully." << std::endl;
+    }
+
+    // Class probabilities, one row per sample and one column per class
+    MatrixXs predict_proba(const MatrixXs &X) const {
+        check_fitted(X.cols());
+        MatrixXs logits = X * weights_;
+        logits.rowwise() += bias_.transpose();
+        logits.colwise() -= logits.rowwise().maxCoeff();
+        logits = logits.array().exp();
+        logits.array().colwise() /= logits.rowwise().sum().array();
+        return logits;
+    }
+
+    // Most probable class of each row
+    VectorXs predict(const MatrixXs &X) const override {
+        check_fitted(X.cols());
+        MatrixXs logits = X * weights_;
+        logits.rowwise() += bias_.transpose();
+        VectorXs labels(X.rows());
+        for (Eigen::Index i = 0; i < X.rows(); ++i) {
+            Eigen::Index label;
+            logits.row(i).maxCoeff(&label);
+            labels(i) = static_cast<Scalar>(label);
+        }
+        return labels;
+    }
+
+    // gradients holds the weight gradients column by column (class by class), then the biases
+    void update_parameters(const VectorXs &gradients, double rate) override {
+        if (weights_.size() == 0)
+            throw std::runtime_error("Model has not been trained yet. Call fit() before update_parameters().");
+        if (gradients.size() != weights_.size() + bias_.size())
+            throw std::invalid_argument("Gradient size does not match the number of parameters.");
+        Eigen::Map<VectorXs>(weights_.data(), weights_.size()).noalias() -= rate * gradients.head(weights_.size());
+        bias_.noalias() -= rate * gradients.tail(bias_.size());
+    }
+
+    // Weights column by column (class by class), then the biases
+    VectorXs get_parameters() const override {
+        VectorXs parameters(weights_.size() + bias_.size());
+        parameters << Eigen::Map<const VectorXs>(weights_.data(), weights_.size()), bias_;
+        return parameters;
+    }
+
+    // The number of classes must be known (from fit() or the constructor) to split the vector
+    void set_parameters(const VectorXs &parameters) override {
+        const int num_classes = weights_.size() > 0 ? static_cast<int>(weights_.cols()) : num_classes_;
+        if (num_classes == 0)
+            throw std::runtime_error("Number of classes is unknown. Pass it to the constructor or call fit() first.");
+        if (parameters.size() <= num_classes || parameters.size() % num_classes != 0)
+            throw std::invalid_argument("Parameter count does not match the number of classes.");
+        const Eigen::Index num_features = parameters.size() / num_classes - 1;
+        weights_ = Eigen::Map<const MatrixXs>(parameters.data(), num_features, num_classes);
+        bias_ = parameters.tail(num_classes);
+    }
+
+    std::string name() const override {
+        return "Softmax Regression";
+    }
+
+    std::string description() const override {
+        return "Multinomial logistic regression for multiclass classification.";
+    }
+
+    std::string formula() const override {
+        return "P(y=k|x) = exp(z_k) / Σ_j exp(z_j), where z = W^T * x + b";
+    }
+
+    std::string gradient_formula() const override {
+        return "∂L/∂W = X^T * (P - Y) / n, ∂L/∂b = Σ(P - Y) / n, with Y the one-hot labels";
+    }
+
+    const MatrixXs &get_weights() const {
+        return weights_;
+    }
+    const VectorXs &get_bias() const {
+        return bias_;
+    }
+    int get_num_classes() const {
+        return weights_.size() > 0 ? static_cast<int>(weights_.cols()) : num_classes_;
+    }
+    double get_learning_rate() const {
+        return lr_;
+    }
+    int get_epochs() const {
+        return epochs_;
+    }
+    int get_batch_size() const {
+        return batch_size_;
+    }
+};
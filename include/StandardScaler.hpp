@@ -0,0 +1,197 @@
+#pragma once
+#include <Eigen/Dense>
+#include "types.hpp"
+#include <stdexcept>
+#include <vector>
+#include "parallel.hpp"
+
+// Standardizes features (and optionally the target) to zero mean and unit variance.
+// Statistics are accumulated with Welford's update and kept in double precision whatever
+// the Scalar type, so they can be built up batch by batch (partial_fit) or per chunk and
+// combined (merge). A fitted scaler is applied in place, so transforming a batch at
+// predict time allocates nothing.
+class StandardScaler {
+private:
+    // Running count, mean and sum of squared deviations of each column
+    struct Moments {
+        long long count = 0;
+        Eigen::ArrayXd mean;
+        Eigen::ArrayXd m2;
+
+        void add(const Eigen::Ref<const MatrixXs> &X) {
+            if (count == 0) {
+                mean = Eigen::ArrayXd::Zero(X.cols());
+                m2 = Eigen::ArrayXd::Zero(X.cols());
+            }
+            // Column by column so every pass reads one contiguous column
+            for (Eigen::Index j = 0; j < X.cols(); ++j) {
+                double n = static_cast<double>(count);
+                double column_mean = mean(j);
+                double column_m2 = m2(j);
+                for (Eigen::Index i = 0; i < X.rows(); ++i) {
+                    n += 1.0;
+                    const double delta = X(i, j) - column_mean;
+                    column_mean += delta / n;
+                    column_m2 += delta * (X(i, j) - column_mean);
+                }
+                mean(j) = column_mean;
+                m2(j) = column_m2;
+            }
+            count += X.rows();
+        }
+
+        // Chan et al. pairwise combination of two sets of moments
+        void merge(const Moments &other) {
+            if (other.count == 0) {
+                return;
+            }
+            if (count == 0) {
+                *this = other;
+                return;
+            }
+            const double n_a = static_cast<double>(count);
+            const double n_b = static_cast<double>(other.count);
+            const double n = n_a + n_b;
+            const Eigen::ArrayXd delta = other.mean - mean;
+            mean += delta * (n_b / n);
+            m2 += other.m2 + delta.square() * (n_a * n_b / n);
+            count += other.count;
+        }
+    };
+
+    Moments features_;
+    Moments target_;
+
+    // Cached in Scalar precision for transform
+    RowVectorXs mean_;
+    RowVectorXs inv_scale_;
+    Scalar target_mean_ = 0;
+    Scalar target_scale_ = 1;
+
+    // Columns with (near) zero variance are centered but not scaled
+    static Eigen::ArrayXd scale_of(const Moments &moments) {
+        Eigen::ArrayXd scale = (moments.m2 / static_cast<double>(moments.count)).sqrt();
+        return (scale > 1e-10).select(scale, 1.0);
+    }
+
+    void update_cache() {
+        if (features_.count > 0) {
+            mean_ = features_.mean.cast<Scalar>().matrix().transpose();
+            inv_scale_ = scale_of(features_).inverse().cast<Scalar>().matrix().transpose();
+        }
+        if (target_.count > 0) {
+            target_mean_ = static_cast<Scalar>(target_.mean(0));
+            target_scale_ = static_cast<Scalar>(scale_of(target_)(0));
+        }
+    }
+
+    void check_features(Eigen::Index cols) const {
+        if (features_.count == 0) {
+            throw std::runtime_error("StandardScaler is not fitted.");
+        }
+        if (cols != features_.mean.size()) {
+            throw std::invalid_argument("Number of columns does not match the fitted scaler.");
+        }
+    }
+
+    void check_target() const {
+        if (target_.count == 0) {
+            throw std::runtime_error("StandardScaler was not fitted on a target.");
+        }
+    }
+
+    // Moments of the rows of X, computed on num_threads row chunks and combined in chunk order
+    static Moments parallel_moments(const Eigen::Ref<const MatrixXs> &X, unsigned num_threads) {
+        num_threads = resolveThreadCount(num_threads);
+        std::vector<Moments> partial(num_threads);
+        parallelFor(0, X.rows(), num_threads, [&](size_t begin, size_t end, unsigned t) {
+            partial[t].add(X.middleRows(begin, end - begin));
+        });
+        Moments total;
+        for (const auto &moments : partial) {
+            total.merge(moments);
+        }
+        return total;
+    }
+
+public:
+    // Forget any statistics and fit on X (and y) from scratch. 0 threads uses every core.
+    void fit(const Eigen::Ref<const MatrixXs> &X, unsigned num_threads = 1) {
+        if (X.rows() == 0 || X.cols() == 0) {
+            throw std::invalid_argument("Input matrix cannot be empty");
+        }
+        features_ = parallel_moments(X, num_threads);
+        target_ = Moments();
+        update_cache();
+    }
+
+    void fit(const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y, unsigned num_threads = 1) {
+        if (X.rows() != y.size()) {
+            throw std::invalid_argument("X and y must have the same number of rows.");
+        }
+        fit(X, num_threads);
+        target_ = parallel_moments(y, num_threads);
+        update_cache();
+    }
+
+    // Fold another batch of rows into the statistics
+    void partial_fit(const Eigen::Ref<const MatrixXs> &X) {
+        if (features_.count > 0 && X.cols() != features_.mean.size()) {
+            throw std::invalid_argument("Number of columns does not match the fitted scaler.");
+        }
+        features_.add(X);
+        update_cache();
+    }
+
+    void partial_fit(const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y) {
+        if (X.rows() != y.size()) {
+            throw std::invalid_argument("X and y must have the same number of rows.");
+        }
+        partial_fit(X);
+        target_.add(y);
+        update_cache();
+    }
+
+    // Combine with a scaler fitted on a different chunk of the same columns
+    void merge(const StandardScaler &other) {
+        if (features_.count > 0 && other.features_.count > 0 &&
+            features_.mean.size() != other.features_.mean.size()) {
+            throw std::invalid_argument("Cannot merge scalers fitted on different numbers of columns.");
+        }
+        features_.merge(other.features_);
+        target_.merge(other.target_);
+        update_cache();
+    }
+
+    // In-place transforms; X may be a whole matrix or a block of one
+    void transform(Eigen::Ref<MatrixXs> X) const {
+        check_features(X.cols());
+        X.array().rowwise() -= mean_.array();
+        X.array().rowwise() *= inv_scale_.array();
+    }
+
+    void inverse_transform(Eigen::Ref<MatrixXs> X) const {
+        check_features(X.cols());
+        X.array().rowwise() /= inv_scale_.array();
+        X.array().rowwise() += mean_.array();
+    }
+
+    void transform_target(Eigen::Ref<VectorXs> y) const {
+        check_target();
+        y.array() = (y.array() - target_mean_) / target_scale_;
+    }
+
+    // Map predictions made in scaled target units back to the original units
+    void inverse_transform_target(Eigen::Ref<VectorXs> y) const {
+        check_target();
+        y.array() = y.array() * target_scale_ + target_mean_;
+    }
+
+    bool is_fitted() const { return features_.count > 0; }
+    bool has_target() const { return target_.count > 0; }
+    long long get_count() const { return features_.count; }
+    Eigen::VectorXd get_mean() const { return features_.mean.matrix(); }
+    Eigen::VectorXd get_scale() const { return scale_of(features_).matrix(); }
+    double get_target_mean() const { check_target(); return target_.mean(0); }
+    double get_target_scale() const { check_target(); return scale_of(target_)(0); }
+};
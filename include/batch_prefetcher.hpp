@@ -0,0 +1,127 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <Eigen/Dense>
+#include "types.hpp"
+
+// Bounded single-producer/single-consumer pipeline of preallocated batches. During a pass a
+// background thread fills free slots through fill(X, y), which returns the number of rows it
+// wrote (0 ends the pass), while the calling thread trains on the slots already filled. Up to
+// depth batches are prepared ahead of the one being consumed; slots are reused across passes.
+class BatchPrefetcher {
+public:
+    struct Batch {
+        MatrixXs X;
+        VectorXs y;
+        int rows = 0;
+    };
+    using Fill = std::function<int(MatrixXs &X, VectorXs &y)>;
+
+    BatchPrefetcher(int depth, int batch_size, int num_features) : slots_(depth + 1) {
+        if (depth <= 0) throw std::invalid_argument("Prefetch depth must be positive.");
+        for (auto &slot : slots_) {
+            slot.X.resize(batch_size, num_features);
+            slot.y.resize(batch_size);
+        }
+    }
+
+    BatchPrefetcher(const BatchPrefetcher &) = delete;
+    BatchPrefetcher &operator=(const BatchPrefetcher &) = delete;
+
+    ~BatchPrefetcher() { stop(); }
+
+    // Begin a pass, abandoning any pass still running. fill runs on the background thread only.
+    void start(Fill fill) {
+        stop();
+        head_ = 0;
+        ready_ = 0;
+        in_use_ = false;
+        done_ = false;
+        stopping_ = false;
+        error_ = nullptr;
+        producer_ = std::thread([this, fill = std::move(fill)]() { produce(fill); });
+    }
+
+    // Hand back the batch returned by the previous call and wait for the next one. Returns
+    // nullptr at the end of the pass; an exception thrown by fill is rethrown here.
+    const Batch *next() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (in_use_) {
+            head_ = (head_ + 1) % slots_.size();
+            in_use_ = false;
+            free_.notify_one();
+        }
+        filled_.wait(lock, [this]() { return ready_ > 0 || done_; });
+        if (ready_ == 0) {
+            lock.unlock();
+            stop();
+            if (error_) std::rethrow_exception(error_);
+            return nullptr;
+        }
+        ready_--;
+        in_use_ = true;
+        return &slots_[head_];
+    }
+
+    // Stop the background thread once it finishes the batch it is filling
+    void stop() {
+        if (!producer_.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        free_.notify_one();
+        producer_.join();
+    }
+
+    int getDepth() const { return static_cast<int>(slots_.size()) - 1; }
+
+private:
+    void produce(const Fill &fill) {
+        try {
+            for (;;) {
+                size_t slot;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    free_.wait(lock, [this]() { return stopping_ || in_use_ + ready_ < slots_.size(); });
+                    if (stopping_) return;
+                    slot = (head_ + in_use_ + ready_) % slots_.size();
+                }
+                // The slot is neither ready nor in use, so it is filled without holding the lock
+                Batch &batch = slots_[slot];
+                batch.rows = fill(batch.X, batch.y);
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (batch.rows <= 0) {
+                    done_ = true;
+                    filled_.notify_one();
+                    return;
+                }
+                ready_++;
+                filled_.notify_one();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = std::current_exception();
+            done_ = true;
+            filled_.notify_one();
+        }
+    }
+
+    std::vector<Batch> slots_;
+    std::thread producer_;
+    std::mutex mutex_;
+    std::condition_variable free_;
+    std::condition_variable filled_;
+    // slots_[head_] is the batch being consumed (when in_use_), followed by ready_ filled batches
+    size_t head_ = 0;
+    size_t ready_ = 0;
+    bool in_use_ = false;
+    bool done_ = false;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <Eigen/Dense>
+#include "types.hpp"
+#include "csv_loader.hpp"
+#include "numeric_parse.hpp"
+
+// Source of fixed-size row batches for out-of-core training.
+// A pass over the data ends when next() returns 0; reset() starts the next pass.
+class BatchSource {
+public:
+    // Fill the first rows of X and y with the next batch and return how many rows were written.
+    // X and y are resized only when their shape does not fit the batch, so buffers can be reused.
+    virtual int next(MatrixXs &X, VectorXs &y) = 0;
+    virtual void reset() = 0;
+    virtual int getBatchSize() const = 0;
+    virtual int getNumFeatures() const = 0;
+    virtual ~BatchSource() = default;
+};
+
+// Streams numeric feature/target columns from a CSV file on disk, holding at most
+// one record and one batch in memory. Rows that do not parse are skipped.
+class CSVBatchStream : public BatchSource {
+private:
+    std::string filename_;
+    char delimiter_;
+    int batch_size_;
+    std::ifstream file_;
+    std::vector<int> feature_indices_;
+    int target_index_ = -1;
+    size_t min_fields_ = 0;
+    size_t skipped_rows_ = 0;
+
+    // Reused between records
+    std::string record_;
+    std::string line_;
+    std::vector<std::string_view> fields_;
+
+    // Read one record; a quoted field may span several lines
+    bool readRecord() {
+        if (!CSVLoader::readRecord(file_, record_, line_)) return false;
+        fields_.clear();
+        CSVLoader::parseRecord(record_, 0, delimiter_, fields_);
+        return true;
+    }
+
+    void open() {
+        file_.close();
+        file_.clear();
+        file_.open(filename_);
+        if (!file_.is_open()) {
+            throw std::runtime_error("Could not open file: " + filename_);
+        }
+    }
+
+public:
+    CSVBatchStream(const std::string &filename,
+                   const std::vector<std::string> &feature_columns,
+                   const std::string &target_column,
+                   int batch_size = 1024,
+                   char delimiter = ',')
+        : filename_(filename), delimiter_(delimiter), batch_size_(batch_size) {
+        if (batch_size <= 0) throw std::invalid_argument("Batch size must be positive.");
+        open();
+        if (!readRecord()) {
+            throw std::runtime_error("No header found in file: " + filename_);
+        }
+
+        // Resolve column names against the header
+        auto column_index = [this](const std::string &name) {
+            const std::string wanted = CSVLoader::trim(name);
+            for (size_t i = 0; i < fields_.size(); ++i) {
+                if (CSVLoader::trim(std::string(fields_[i])) == wanted) return static_cast<int>(i);
+            }
+            throw std::runtime_error("Column not found: " + name);
+        };
+        for (const auto &col : feature_columns) {
+            feature_indices_.push_back(column_index(col));
+        }
+        target_index_ = column_index(target_column);
+        min_fields_ = target_index_ + 1;
+        for (int idx : feature_indices_) {
+            min_fields_ = std::max(min_fields_, static_cast<size_t>(idx) + 1);
+        }
+    }
+
+    int next(MatrixXs &X, VectorXs &y) override {
+        if (X.rows() < batch_size_ || X.cols() != getNumFeatures()) X.resize(batch_size_, getNumFeatures());
+        if (y.size() < batch_size_) y.resize(batch_size_);
+
+        int rows = 0;
+        while (rows < batch_size_ && readRecord()) {
+            bool is_valid = fields_.size() >= min_fields_ && parseNumber(fields_[target_index_], y(rows));
+            for (size_t j = 0; is_valid && j < feature_indices_.size(); ++j) {
+                is_valid = parseNumber(fields_[feature_indices_[j]], X(rows, j));
+            }
+            if (is_valid) {
+                rows++;
+            } else {
+                skipped_rows_++;
+            }
+        }
+        return rows;
+    }
+
+    // Rewind to the first data row
+    void reset() override {
+        open();
+        readRecord();  // header
+        skipped_rows_ = 0;
+    }
+
+    int getBatchSize() const override { return batch_size_; }
+    int getNumFeatures() const override { return static_cast<int>(feature_indices_.size()); }
+
+    // Rows skipped so far in the current pass
+    size_t getNumSkippedRows() const { return skipped_rows_; }
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Dictionary-encoded string column: every distinct value is stored once and each
+// data row holds a 32-bit code into the dictionary. Codes are assigned in order of
+// first appearance. Move-only, since the lookup table points into the dictionary.
+class CategoricalColumn {
+    public:
+        static constexpr uint32_t kMissing = std::numeric_limits<uint32_t>::max();
+
+        CategoricalColumn() = default;
+        CategoricalColumn(const CategoricalColumn&) = delete;
+        CategoricalColumn& operator=(const CategoricalColumn&) = delete;
+        CategoricalColumn(CategoricalColumn&&) = default;
+        CategoricalColumn& operator=(CategoricalColumn&&) = default;
+
+        // Append a row holding value and return its code
+        uint32_t encode(std::string_view value) {
+            auto it = m_lookup.find(value);
+            uint32_t code;
+            if (it != m_lookup.end()) {
+                code = it->second;
+            } else {
+                code = static_cast<uint32_t>(m_values.size());
+                m_values.emplace_back(value);
+                m_lookup.emplace(m_values.back(), code);
+            }
+            m_codes.push_back(code);
+            return code;
+        }
+
+        // Append a row that has no value for this column (short record)
+        void pushMissing() { m_codes.push_back(kMissing); }
+
+        void clear() {
+            m_values.clear();
+            m_lookup.clear();
+            m_codes.clear();
+        }
+
+        void reserve(size_t rows) { m_codes.reserve(rows); }
+
+        // Code of a data row (header excluded)
+        uint32_t code(size_t row) const { return m_codes[row]; }
+        const std::vector<uint32_t>& codes() const { return m_codes; }
+
+        const std::string& value(uint32_t code) const { return m_values[code]; }
+        size_t numCategories() const { return m_values.size(); }
+        size_t numRows() const { return m_codes.size(); }
+
+    private:
+        std::deque<std::string> m_values;  // deque keeps the strings in place as it grows
+        std::unordered_map<std::string_view, uint32_t> m_lookup;
+        std::vector<uint32_t> m_codes;
+};
@@ -0,0 +1,179 @@
+#pragma once
+#include <Eigen/Dense>
+#include "types.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "dataset.hpp"
+#include "model.hpp"
+#include "parallel.hpp"
+
+// Row indices (into the Dataset being split) of one train/test fold
+struct Fold {
+    std::vector<int> train;
+    std::vector<int> test;
+};
+
+// Splits the rows into n_splits folds of (nearly) equal size; each row is in exactly one test set
+class KFold {
+    private:
+        int n_splits_;
+        bool shuffle_;
+        unsigned int seed_;
+
+    protected:
+        // Turn a test-fold assignment per row into train/test index lists
+        static std::vector<Fold> makeFolds(const std::vector<int> &fold_of_row, int n_splits) {
+            std::vector<Fold> folds(n_splits);
+            for (int row = 0; row < static_cast<int>(fold_of_row.size()); ++row) {
+                for (int k = 0; k < n_splits; ++k) {
+                    (k == fold_of_row[row] ? folds[k].test : folds[k].train).push_back(row);
+                }
+            }
+            return folds;
+        }
+
+        void checkRows(int num_rows) const {
+            if (num_rows < n_splits_) {
+                throw std::invalid_argument("Number of folds cannot be greater than the number of rows.");
+            }
+        }
+
+    public:
+        KFold(int n_splits = 5, bool shuffle = true, unsigned int seed = 0)
+            : n_splits_(n_splits), shuffle_(shuffle), seed_(seed) {
+            if (n_splits < 2) {
+                throw std::invalid_argument("Number of folds must be at least 2.");
+            }
+        }
+        virtual ~KFold() = default;
+
+        virtual std::vector<Fold> split(const Dataset &dataset) const {
+            const int num_rows = dataset.getNumRows();
+            checkRows(num_rows);
+            std::vector<int> order(num_rows);
+            std::iota(order.begin(), order.end(), 0);
+            if (shuffle_) {
+                std::shuffle(order.begin(), order.end(), std::default_random_engine(seed_));
+            }
+            // Consecutive runs of the (shuffled) order form the test folds
+            std::vector<int> fold_of_row(num_rows);
+            for (int i = 0; i < num_rows; ++i) {
+                fold_of_row[order[i]] = static_cast<int>(static_cast<long long>(i) * n_splits_ / num_rows);
+            }
+            return makeFolds(fold_of_row, n_splits_);
+        }
+
+        int getNumSplits() const { return n_splits_; }
+        bool getShuffle() const { return shuffle_; }
+        unsigned int getSeed() const { return seed_; }
+};
+
+// K-fold split that keeps each target value's share of rows the same in every fold.
+// Meant for classification targets: every distinct target value is treated as a class.
+class StratifiedKFold : public KFold {
+    public:
+        using KFold::KFold;
+
+        std::vector<Fold> split(const Dataset &dataset) const override {
+            const int num_rows = dataset.getNumRows();
+            checkRows(num_rows);
+            std::map<Scalar, std::vector<int>> classes;
+            for (int row = 0; row < num_rows; ++row) {
+                classes[dataset.getRowY(row)].push_back(row);
+            }
+            // Deal each class's rows round-robin over the folds, continuing where the previous
+            // class stopped so fold sizes stay balanced too
+            std::default_random_engine rng(getSeed());
+            std::vector<int> fold_of_row(num_rows);
+            int next_fold = 0;
+            for (auto &entry : classes) {
+                std::vector<int> &rows = entry.second;
+                if (getShuffle()) {
+                    std::shuffle(rows.begin(), rows.end(), rng);
+                }
+                for (int row : rows) {
+                    fold_of_row[row] = next_fold;
+                    next_fold = (next_fold + 1) % getNumSplits();
+                }
+            }
+            return makeFolds(fold_of_row, getNumSplits());
+        }
+};
+
+using ModelFactory = std::function<std::unique_ptr<Model>()>;
+using Scorer = std::function<double(const VectorXs &y_true, const VectorXs &y_pred)>;
+
+struct CrossValidationResult {
+    std::vector<double> fold_scores;
+    double mean_score = 0.0;
+    double std_score = 0.0;  // population standard deviation over the folds
+};
+
+inline double meanSquaredErrorScore(const VectorXs &y_true, const VectorXs &y_pred) {
+    return (y_true - y_pred).squaredNorm() / y_true.size();
+}
+
+// Share of predictions that round to the true label
+inline double accuracyScore(const VectorXs &y_true, const VectorXs &y_pred) {
+    return (y_pred.array().round() == y_true.array()).template cast<double>().mean();
+}
+
+// Train a fresh model from factory on every fold's training rows and score its predictions on
+// the fold's test rows. Folds are row-index views over the one shared Dataset and are trained
+// concurrently on a thread pool of num_threads workers (0 = one per core); each fold gets its
+// own model, so models need not be thread-safe, but factory is called from the pool threads.
+inline CrossValidationResult crossValidate(const ModelFactory &factory,
+                                           const Dataset &dataset,
+                                           const std::vector<Fold> &folds,
+                                           const Scorer &scorer,
+                                           unsigned num_threads = 0) {
+    if (folds.empty()) {
+        throw std::invalid_argument("At least one fold is required.");
+    }
+    ThreadPool pool(std::min<unsigned>(resolveThreadCount(num_threads), folds.size()));
+    std::vector<std::future<double>> scores;
+    scores.reserve(folds.size());
+    for (const Fold &fold : folds) {
+        scores.push_back(pool.submit([&factory, &dataset, &scorer, &fold]() {
+            std::unique_ptr<Model> model = factory();
+            if (!model) {
+                throw std::runtime_error("Model factory returned no model.");
+            }
+            model->fit(dataset.subset(fold.train));
+            const Dataset test = dataset.subset(fold.test);
+            const VectorXs y_pred = model->predict(test.getX());
+            return scorer(test.getY(), y_pred);
+        }));
+    }
+
+    CrossValidationResult result;
+    for (auto &score : scores) {
+        result.fold_scores.push_back(score.get());
+    }
+    const double n = static_cast<double>(result.fold_scores.size());
+    result.mean_score = std::accumulate(result.fold_scores.begin(), result.fold_scores.end(), 0.0) / n;
+    double squared_deviation = 0.0;
+    for (double score : result.fold_scores) {
+        squared_deviation += (score - result.mean_score) * (score - result.mean_score);
+    }
+    result.std_score = std::sqrt(squared_deviation / n);
+    return result;
+}
+
+// k-fold cross-validation with shuffled, unstratified folds
+inline CrossValidationResult crossValidate(const ModelFactory &factory,
+                                           const Dataset &dataset,
+                                           int k,
+                                           const Scorer &scorer,
+                                           unsigned num_threads = 0,
+                                           unsigned int seed = 0) {
+    return crossValidate(factory, dataset, KFold(k, true, seed).split(dataset), scorer, num_threads);
+}
@@ -1,11 +1,15 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <map>
 #include <stdexcept>
 #include <algorithm>
+#include "categorical.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
 
 class CSVLoader { 
     public:
@@ -14,27 +18,109 @@ class CSVLoader {
         {
         }
 
+        // Restrict loading to the named columns. Call before load()/loadMapped(); fields of other
+        // columns are skipped by the tokenizer without being stored, and column indices refer to
+        // the selected columns in file order. An empty list selects every column.
+        void selectColumns(const std::vector<std::string>& column_names) {
+            m_selected.clear();
+            for (const auto& name : column_names) {
+                m_selected.push_back(trim(name));
+            }
+        }
+
+        // Dictionary-encode the named columns while loading. Call before load()/loadMapped().
+        // Each distinct value is kept once and every row gets a 32-bit code (see getCategorical);
+        // with load() the cells themselves are not stored, so getField returns an empty view for them.
+        void setCategoricalColumns(const std::vector<std::string>& column_names) {
+            m_categorical_names.clear();
+            for (const auto& name : column_names) {
+                m_categorical_names.push_back(trim(name));
+            }
+        }
+
         void load(){
             std::ifstream file(m_filename);
             if (!file.is_open())
             {
                 throw std::runtime_error("Could not open file: " + m_filename);
             }
-            m_data.clear();
+            clear();
             std::string line;
+            std::string scratch;
 
-            while (std::getline(file, line))
+            if (readRecord(file, line, scratch))
+            {
+                std::vector<std::string> header = parseLine(line);
+                buildHeader(header.begin(), header.end());
+                m_data.emplace_back(m_header.begin(), m_header.end());
+            }
+            while (readRecord(file, line, scratch))
             {
                 m_data.push_back(parseLine(line));
+                for (size_t slot = 0; slot < m_categorical.size(); ++slot)
+                {
+                    // parseLine encoded every categorical cell it saw; fill in short records
+                    if (m_categorical[slot].numRows() < m_data.size() - 1) m_categorical[slot].pushMissing();
+                }
             }
+        }
 
-            // Create column name to index mapping
-            if (!m_data.empty()) {
-                const auto& header = m_data[0];
-                for (size_t i = 0; i < header.size(); ++i) {
-                    m_column_indices[trim(header[i])] = i;
+        // Zero-copy load: maps the file and records string_view offsets for every
+        // field instead of copying each cell into its own std::string.
+        // Fields stay valid until the next load() / loadMapped() or destruction.
+        // With num_threads != 1 the file is split into byte ranges aligned to record
+        // boundaries and each range is tokenized on its own thread (0 = all cores);
+        // records keep their file order.
+        void loadMapped(unsigned num_threads = 1){
+            clear();
+            m_mapped.open(m_filename);
+            m_mapped.adviseSequential();
+
+            const std::string_view text = m_mapped.view();
+            m_record_offsets.push_back(0);
+            size_t body = 0;
+            if (!text.empty())
+            {
+                std::vector<std::string_view> header;
+                body = parseRecord(text, 0, m_delimiter, header);
+                buildHeader(header.begin(), header.end());
+                for (size_t i = 0; i < header.size(); ++i)
+                {
+                    if (m_keep[i]) m_fields.push_back(header[i]);
                 }
+                m_record_offsets.push_back(m_fields.size());
             }
+
+            num_threads = resolveThreadCount(num_threads);
+            if (num_threads > 1 && text.size() >= body + kMinParallelBytes * num_threads)
+            {
+                parseParallel(text, body, num_threads);
+            }
+            else
+            {
+                parseRange(text, body, text.size(), m_fields, m_record_offsets);
+            }
+            encodeCategoricalFields();
+        }
+
+        bool isMapped() const { return !m_record_offsets.empty(); }
+
+        // Number of records including the header row (same indexing as getData())
+        size_t getNumRecords() const {
+            return isMapped() ? m_record_offsets.size() - 1 : m_data.size();
+        }
+
+        size_t getNumFields(size_t record) const {
+            return isMapped() ? m_record_offsets[record + 1] - m_record_offsets[record]
+                              : m_data[record].size();
+        }
+
+        // Works for both load modes; for mapped loads the view points into the file mapping
+        std::string_view getField(size_t record, size_t column) const {
+            if (isMapped()) {
+                return m_fields[m_record_offsets[record] + column];
+            }
+            return m_data[record][column];
         }
 
         const std::vector<std::vector<std::string>> &getData() const
@@ -44,14 +130,10 @@ class CSVLoader {
 
         // Get all column names from the header
         std::vector<std::string> getColumnNames() const {
-            if (m_data.empty()) {
+            if (getNumRecords() == 0) {
                 throw std::runtime_error("No data loaded. Call load() first.");
             }
-            std::vector<std::string> trimmed_names;
-            for (const auto& name : m_data[0]) {
-                trimmed_names.push_back(trim(name));
-            }
-            return trimmed_names;
+            return m_header;
         }
 
         // Get the index of a column by name
@@ -63,17 +145,28 @@ class CSVLoader {
             return it->second;
         }
 
+        // Dictionary of a column registered with setCategoricalColumns, or nullptr for other columns
+        const CategoricalColumn* getCategorical(int column_index) const {
+            if (column_index < 0 || column_index >= static_cast<int>(m_categorical_slot.size()) ||
+                m_categorical_slot[column_index] < 0) {
+                return nullptr;
+            }
+            return &m_categorical[m_categorical_slot[column_index]];
+        }
+
+        const CategoricalColumn& getCategorical(const std::string& column_name) const {
+            const CategoricalColumn* column = getCategorical(getColumnIndex(column_name));
+            if (column == nullptr) {
+                throw std::runtime_error("Column is not categorical: " + column_name);
+            }
+            return *column;
+        }
+
         // Check if a column exists
         bool hasColumn(const std::string& column_name) const {
             return m_column_indices.find(trim(column_name)) != m_column_indices.end();
         }
 
-    private:
-        std::string m_filename;
-        char m_delimiter{};
-        std::vector<std::vector<std::string>> m_data;
-        std::map<std::string, int> m_column_indices;  // Maps column names to their indices
-
         // Helper function to trim whitespace from both ends of a string
         static std::string trim(const std::string& str) {
             const std::string whitespace = " \t\r\n";
@@ -85,31 +178,265 @@ class CSVLoader {
             return str.substr(start, end - start + 1);
         }
 
-        std::vector<std::string> parseLine(const std::string &line)
+        // Strip the quotes around a field that is quoted as a whole. Quotes elsewhere are kept and
+        // doubled quotes are not unescaped ("x""y" gives x""y), so the cell stays a view into the
+        // input; every reader goes through parseRecord and returns the same cells.
+        static std::string_view unquote(std::string_view field) {
+            if (field.size() >= 2 && field.front() == '"' && field.back() == '"') {
+                return field.substr(1, field.size() - 2);
+            }
+            return field;
+        }
+
+        // Read one record from a stream into record: a quoted field may span several lines, which
+        // are joined with '\n' as in the file. line is scratch space. Used by load() and
+        // CSVBatchStream so records split the same way as in loadMapped().
+        static bool readRecord(std::istream &in, std::string &record, std::string &line)
         {
-            std::vector<std::string> result;
-            std::string field;
-            std::istringstream stream(line);
-            bool inQuotes = false;
-            char c;
+            if (!std::getline(in, record)) return false;
+            while (std::count(record.begin(), record.end(), '"') % 2 != 0 && std::getline(in, line))
+            {
+                record.push_back('\n');
+                record += line;
+            }
+            return true;
+        }
 
-            while (stream.get(c))
+        // Parse the record starting at pos into field views and return the position of the next record.
+        // Shared by load(), loadMapped() and CSVBatchStream so every reader tokenizes the same way.
+        // Delimiters and newlines inside quotes do not end a field; a trailing '\r' is dropped.
+        // If keep is given, only fields whose column has a nonzero entry are appended.
+        static size_t parseRecord(std::string_view text, size_t pos, char delimiter, std::vector<std::string_view> &fields,
+                                  const std::vector<char> *keep = nullptr)
+        {
+            bool inQuotes = false;
+            size_t field_start = pos;
+            size_t column = 0;
+            auto kept = [&]() { return keep == nullptr || (column < keep->size() && (*keep)[column]); };
+            size_t i = pos;
+            for (; i < text.size(); ++i)
             {
+                const char c = text[i];
                 if (c == '"')
                 {
                     inQuotes = !inQuotes;
                 }
-                else if (c == m_delimiter && !inQuotes)
+                else if (!inQuotes && c == delimiter)
                 {
-                    result.push_back(field);
-                    field.clear();
+                    if (kept()) fields.push_back(unquote(text.substr(field_start, i - field_start)));
+                    field_start = i + 1;
+                    ++column;
                 }
-                else
+                else if (!inQuotes && c == '\n')
                 {
-                    field.push_back(c);
+                    break;
+                }
+            }
+            size_t field_end = i;
+            if (field_end > field_start && text[field_end - 1] == '\r')
+            {
+                --field_end;
+            }
+            if (kept()) fields.push_back(unquote(text.substr(field_start, field_end - field_start)));
+            return i + 1;
+        }
+
+    private:
+        std::string m_filename;
+        char m_delimiter{};
+        std::vector<std::vector<std::string>> m_data;
+        std::map<std::string, int> m_column_indices;  // Maps column names to their indices
+        std::vector<std::string> m_header;             // Trimmed column names
+        std::vector<std::string> m_selected;           // Projection from selectColumns(); empty = all
+        std::vector<char> m_keep;                      // Per file column: is it stored?
+        std::vector<std::string> m_categorical_names;  // From setCategoricalColumns()
+        std::vector<int> m_categorical_slot;           // Per stored column: index into m_categorical or -1
+        std::vector<CategoricalColumn> m_categorical;
+
+        // Storage for loadMapped(): all fields back to back, record i spans
+        // m_fields[m_record_offsets[i], m_record_offsets[i + 1])
+        MappedFile m_mapped;
+        std::vector<std::string_view> m_fields;
+        std::vector<size_t> m_record_offsets;
+
+        // Below this many bytes per thread, splitting costs more than it saves
+        static constexpr size_t kMinParallelBytes = 1 << 16;
+
+        void clear() {
+            m_data.clear();
+            m_column_indices.clear();
+            m_header.clear();
+            m_keep.clear();
+            m_categorical_slot.clear();
+            m_categorical.clear();
+            m_fields.clear();
+            m_record_offsets.clear();
+            m_mapped.close();
+        }
+
+        // Record the header and work out which file columns the projection keeps
+        template <typename It>
+        void buildHeader(It first, It last) {
+            for (; first != last; ++first) {
+                std::string name = trim(std::string(*first));
+                const bool keep = m_selected.empty() ||
+                                  std::find(m_selected.begin(), m_selected.end(), name) != m_selected.end();
+                m_keep.push_back(keep);
+                if (keep) {
+                    m_column_indices[name] = m_header.size();
+                    m_header.push_back(std::move(name));
+                }
+            }
+            for (const auto& name : m_selected) {
+                if (m_column_indices.find(name) == m_column_indices.end()) {
+                    throw std::runtime_error("Column not found: " + name);
+                }
+            }
+
+            // Sized once here and never grown, so dictionaries stay put while parsing
+            m_categorical_slot.assign(m_header.size(), -1);
+            m_categorical.reserve(m_categorical_names.size());
+            for (const auto& name : m_categorical_names) {
+                int& slot = m_categorical_slot[getColumnIndex(name)];
+                if (slot < 0) {
+                    slot = m_categorical.size();
+                    m_categorical.emplace_back();
+                }
+            }
+        }
+
+        int categoricalSlot(size_t column) const {
+            return column < m_categorical_slot.size() ? m_categorical_slot[column] : -1;
+        }
+
+        // Encode the categorical columns of a mapped load; the views already point into the file
+        void encodeCategoricalFields() {
+            for (size_t column = 0; column < m_categorical_slot.size(); ++column) {
+                const int slot = m_categorical_slot[column];
+                if (slot < 0) continue;
+                CategoricalColumn& categorical = m_categorical[slot];
+                categorical.reserve(getNumRecords());
+                for (size_t record = 1; record < getNumRecords(); ++record) {
+                    if (column < getNumFields(record)) {
+                        categorical.encode(getField(record, column));
+                    } else {
+                        categorical.pushMissing();
+                    }
                 }
-            };
-            result.push_back(field);
+            }
+        }
+
+        const std::vector<char>* projection() const {
+            // The header itself is always tokenized in full
+            return m_selected.empty() || m_keep.empty() ? nullptr : &m_keep;
+        }
+
+        // Tokenize one record read by load() with parseRecord, then store its cells.
+        // Columns outside the projection are scanned but never copied.
+        std::vector<std::string> parseLine(const std::string &line)
+        {
+            std::vector<std::string_view> fields;
+            parseRecord(line, 0, m_delimiter, fields, projection());
+            std::vector<std::string> result;
+            result.reserve(fields.size());
+            for (std::string_view field : fields)
+            {
+                storeField(result, field);
+            }
             return result;
-        };
+        }
+
+        // Categorical cells are encoded on the spot and stored as empty strings, which do not allocate
+        void storeField(std::vector<std::string> &result, std::string_view field)
+        {
+            const int slot = categoricalSlot(result.size());
+            if (slot >= 0)
+            {
+                m_categorical[slot].encode(field);
+                result.emplace_back();
+            }
+            else
+            {
+                result.emplace_back(field);
+            }
+        }
+
+        // Parse the records in [begin, end), appending fields and the end offset of every record
+        void parseRange(std::string_view text, size_t begin, size_t end,
+                        std::vector<std::string_view> &fields, std::vector<size_t> &record_offsets) const
+        {
+            size_t pos = begin;
+            while (pos < end)
+            {
+                pos = parseRecord(text, pos, m_delimiter, fields, projection());
+                record_offsets.push_back(fields.size());
+            }
+        }
+
+        // Parse the records in [begin, end of text) on num_threads threads, appending them in file order
+        void parseParallel(std::string_view text, size_t begin, unsigned num_threads)
+        {
+            const size_t size = text.size();
+            std::vector<size_t> bounds(num_threads + 1);
+            for (unsigned t = 0; t <= num_threads; ++t)
+            {
+                bounds[t] = begin + (size - begin) * t / num_threads;
+            }
+
+            // Quote parity of every byte range; a prefix XOR gives the quote state at each range start,
+            // so a newline inside a quoted field is never mistaken for a record boundary
+            std::vector<char> odd_quotes(num_threads);
+            parallelRun(num_threads, [&](unsigned t) {
+                odd_quotes[t] = std::count(text.begin() + bounds[t], text.begin() + bounds[t + 1], '"') % 2;
+            });
+
+            // Move every range start forward to the first record that begins at or after it
+            std::vector<size_t> starts(num_threads + 1, size);
+            starts[0] = begin;
+            bool in_quotes = false;
+            for (unsigned t = 1; t < num_threads; ++t)
+            {
+                in_quotes ^= odd_quotes[t - 1];
+                // Quote state before the byte preceding the range start
+                bool quoted = in_quotes ^ (text[bounds[t] - 1] == '"');
+                size_t start = size;
+                for (size_t i = bounds[t] - 1; i < size; ++i)
+                {
+                    if (text[i] == '"')
+                    {
+                        quoted = !quoted;
+                    }
+                    else if (text[i] == '\n' && !quoted)
+                    {
+                        start = i + 1;
+                        break;
+                    }
+                }
+                starts[t] = std::max(start, starts[t - 1]);
+            }
+
+            std::vector<std::vector<std::string_view>> chunk_fields(num_threads);
+            std::vector<std::vector<size_t>> chunk_offsets(num_threads);
+            parallelRun(num_threads, [&](unsigned t) {
+                parseRange(text, starts[t], starts[t + 1], chunk_fields[t], chunk_offsets[t]);
+            });
+
+            // Join the chunks in file order
+            std::vector<size_t> field_base(num_threads + 1, m_fields.size());
+            std::vector<size_t> record_base(num_threads + 1, m_record_offsets.size() - 1);
+            for (unsigned t = 0; t < num_threads; ++t)
+            {
+                field_base[t + 1] = field_base[t] + chunk_fields[t].size();
+                record_base[t + 1] = record_base[t] + chunk_offsets[t].size();
+            }
+            m_fields.resize(field_base[num_threads]);
+            m_record_offsets.resize(record_base[num_threads] + 1);
+            parallelRun(num_threads, [&](unsigned t) {
+                std::copy(chunk_fields[t].begin(), chunk_fields[t].end(), m_fields.begin() + field_base[t]);
+                for (size_t r = 0; r < chunk_offsets[t].size(); ++r)
+                {
+                    m_record_offsets[record_base[t] + r + 1] = field_base[t] + chunk_offsets[t][r];
+                }
+            });
+        }
 }; 
\ No newline at end of file
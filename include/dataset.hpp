@@ -4,9 +4,21 @@
 #include <fstream>
 #include <sstream>
 #include <Eigen/Dense>
+#include "types.hpp"
 #include <algorithm>
 #include <random>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
 #include "csv_loader.hpp"
+#include "numeric_parse.hpp"
+#include "mapped_file.hpp"
+#include "StandardScaler.hpp"
 
 
 //load csv into a csv loader object
@@ -15,53 +27,160 @@
 
 class Dataset {
     private:
-        Eigen::MatrixXd X_;
-        Eigen::VectorXd y_;
+        // Read-only storage shared by copies of a Dataset: either matrices owned by the
+        // Dataset or columns inside a memory-mapped binary cache file (see loadBinary)
+        struct Storage {
+            MatrixXs X;
+            VectorXs y;
+            std::shared_ptr<const MappedFile> mapping;
+            const Scalar *x_data = nullptr;
+            const Scalar *y_data = nullptr;
+            Eigen::Index rows = 0;
+            Eigen::Index cols = 0;
+            Eigen::Index x_stride = 0;  // distance between feature columns, in elements
+        };
+        using MatrixView = Eigen::Map<const MatrixXs, 0, Eigen::OuterStride<>>;
+        using VectorView = Eigen::Map<const VectorXs>;
+
+        // A row-index view over the storage (from shuffle, trainTestSplit or subset). Creating one
+        // copies no data, but the first getX()/getY() call on it copies its rows into a dense matrix.
+        struct View {
+            std::vector<int> rows;  // storage rows, in view order
+            std::once_flag gathered;
+            std::shared_ptr<const Storage> dense;
+        };
+
+        std::shared_ptr<const Storage> storage_;
+        std::shared_ptr<View> view_;  // null when the Dataset covers its storage in order
+
+        explicit Dataset(std::shared_ptr<const Storage> storage, std::shared_ptr<View> view = nullptr)
+            : storage_(std::move(storage)), view_(std::move(view)) {}
+
+        static std::shared_ptr<const Storage> makeStorage(MatrixXs X, VectorXs y) {
+            auto storage = std::make_shared<Storage>();
+            storage->X = std::move(X);
+            storage->y = std::move(y);
+            storage->x_data = storage->X.data();
+            storage->y_data = storage->y.data();
+            storage->rows = storage->X.rows();
+            storage->cols = storage->X.cols();
+            storage->x_stride = std::max<Eigen::Index>(storage->X.rows(), 1);
+            return storage;
+        }
+
+        static MatrixView xView(const Storage &storage) {
+            return MatrixView(storage.x_data, storage.rows, storage.cols, Eigen::OuterStride<>(storage.x_stride));
+        }
+        static VectorView yView(const Storage &storage) { return VectorView(storage.y_data, storage.rows); }
+
+        // Storage holding exactly this Dataset's rows, in order
+        const Storage &dense() const {
+            if (!view_) {
+                return *storage_;
+            }
+            std::call_once(view_->gathered, [this]() {
+                const MatrixView X = xView(*storage_);
+                const VectorView y = yView(*storage_);
+                const auto &rows = view_->rows;
+                MatrixXs X_rows(rows.size(), X.cols());
+                VectorXs y_rows(rows.size());
+                for (size_t i = 0; i < rows.size(); ++i) {
+                    X_rows.row(i) = X.row(rows[i]);
+                    y_rows(i) = y(rows[i]);
+                }
+                view_->dense = makeStorage(std::move(X_rows), std::move(y_rows));
+            });
+            return *view_->dense;
+        }
+
+        // Storage row of row i of this Dataset
+        int storageRow(int i) const { return view_ ? view_->rows[i] : i; }
+
+        // Binary cache layout: a 64-byte header, a column directory, then one 64-byte aligned block per column
+        static constexpr char kBinaryMagic[8] = {'M', 'L', 'D', 'S', 'E', 'T', '\0', '\0'};
+        static constexpr uint32_t kBinaryVersion = 1;
+        static constexpr uint32_t kByteOrderMark = 0x01020304;
+        static constexpr size_t kBlockAlignment = 64;
+        enum ColumnType : uint32_t { Float64 = 0, Float32 = 1 };
+        static constexpr ColumnType kNativeType = sizeof(Scalar) == sizeof(double) ? Float64 : Float32;
+        enum ColumnRole : uint32_t { Feature = 0, Target = 1 };
+
+        struct BinaryHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t byte_order;
+            uint64_t num_rows;
+            uint64_t num_columns;  // features + target
+            uint64_t directory_offset;
+            uint8_t reserved[24];
+        };
+        struct BinaryColumn {
+            uint32_t type;
+            uint32_t role;
+            uint64_t offset;
+            uint64_t size_bytes;
+        };
+        static_assert(sizeof(BinaryHeader) == 64, "binary header must stay 64 bytes");
+
+        static size_t alignBlock(size_t offset) {
+            return (offset + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+        }
 
     public: 
 
-    Dataset(const Eigen::MatrixXd &X, const Eigen::VectorXd &y) : X_(X), y_(y) {}
+    Dataset(MatrixXs X, VectorXs y) : storage_(makeStorage(std::move(X), std::move(y))) {}
+
+    // Views over the data; copies of a Dataset share storage, so these are valid while any
+    // copy is alive. On a row-index view the first call copies the view's rows into a dense
+    // matrix, kept for later calls; code that only gathers rows should use getStorageX below.
+    Eigen::Ref<const MatrixXs> getX() const { return xView(dense()); }
+    Eigen::Ref<const VectorXs> getY() const { return yView(dense()); }
+    int getNumRows() const { return view_ ? static_cast<int>(view_->rows.size()) : storage_->rows; }
+    int getNumFeatures() const { return storage_->cols; }
+
+    // The shared storage and, for a row-index view, the storage rows it covers (null otherwise):
+    // row i of this Dataset is row (*getStorageRows())[i] of getStorageX(). Never copies.
+    Eigen::Ref<const MatrixXs> getStorageX() const { return xView(*storage_); }
+    Eigen::Ref<const VectorXs> getStorageY() const { return yView(*storage_); }
+    const std::vector<int> *getStorageRows() const { return view_ ? &view_->rows : nullptr; }
+
+    // Row access that never gathers, for code that walks a view row by row
+    Eigen::Ref<const RowVectorXs, 0, Eigen::InnerStride<>> getRowX(int i) const {
+        return xView(*storage_).row(storageRow(i));
+    }
+    Scalar getRowY(int i) const { return storage_->y_data[storageRow(i)]; }
+
+    // True when the data lives in a memory-mapped cache file rather than in owned matrices
+    bool isMapped() const { return storage_->mapping != nullptr; }
+
+    // Row-index view of the given rows (indices into this Dataset); no data is copied
+    Dataset subset(const std::vector<int> &rows) const {
+        auto view = std::make_shared<View>();
+        view->rows.reserve(rows.size());
+        for (int row : rows) {
+            view->rows.push_back(storageRow(row));
+        }
+        return Dataset(storage_, std::move(view));
+    }
 
-    Eigen::MatrixXd getX() const { return X_; }
-    Eigen::VectorXd getY() const { return y_; }
-    int getNumRows() const { return X_.rows(); }
-    int getNumFeatures() const { return X_.cols(); }
     Dataset shuffle(unsigned int seed) const {
-        std::cout << "Shuffling with seed: " << seed << std::endl;
-        std::vector<int> indices(X_.rows());
-        for (int i = 0; i < X_.rows(); ++i) indices[i] = i;
+        std::vector<int> indices(getNumRows());
+        std::iota(indices.begin(), indices.end(), 0);
         std::shuffle(indices.begin(), indices.end(), std::default_random_engine(seed));
-        
-        // Print first few indices to verify shuffling
-        std::cout << "First 5 indices after shuffle: ";
-        for (int i = 0; i < std::min(5, (int)indices.size()); ++i) {
-            std::cout << indices[i] << " ";
-        }
-        std::cout << std::endl;
-        
-        // Create new matrices for shuffled data
-        Eigen::MatrixXd X_shuffled(X_.rows(), X_.cols());
-        Eigen::VectorXd y_shuffled(X_.rows());
-        
-        // Copy data in shuffled order
-        for (int i = 0; i < X_.rows(); ++i) {
-            X_shuffled.row(i) = X_.row(indices[i]);
-            y_shuffled(i) = y_(indices[i]);
-        }
-        
-        return Dataset(X_shuffled, y_shuffled);
+        return subset(indices);
     }
 
     std::pair<Dataset, Dataset> trainTestSplit(double test_size = 0.2, uint seed = std::random_device{}()) {
         std::cout << "Performing train-test split with seed: " << seed << std::endl;
-        // First shuffle the data
-        Dataset shuffled = shuffle(seed);
-        
-        // Then split the dataset into training and testing sets
-        int num_rows = shuffled.getNumRows();
+        // Shuffle the row order, then split it; both sets are views over this Dataset's storage
+        std::vector<int> indices(getNumRows());
+        std::iota(indices.begin(), indices.end(), 0);
+        std::shuffle(indices.begin(), indices.end(), std::default_random_engine(seed));
+
+        int num_rows = getNumRows();
         int num_train = static_cast<int>(num_rows * (1 - test_size));
-        Dataset train_set(shuffled.getX().topRows(num_train), shuffled.getY().head(num_train));
-        Dataset test_set(shuffled.getX().bottomRows(num_rows - num_train), shuffled.getY().tail(num_rows - num_train));
+        Dataset train_set = subset(std::vector<int>(indices.begin(), indices.begin() + num_train));
+        Dataset test_set = subset(std::vector<int>(indices.begin() + num_train, indices.end()));
         
         std::cout << "Split into " << num_train << " training samples and " 
                   << (num_rows - num_train) << " test samples" << std::endl;
@@ -69,192 +188,398 @@ class Dataset {
     }
 
     void saveToCSV(const std::string& filename) const {
+        const MatrixView X = xView(dense());
+        const VectorView y = yView(dense());
         std::ofstream file(filename);
         if (!file.is_open()) {
             throw std::runtime_error("Could not open file: " + filename);
         }
         // Write header
-        for (int i = 0; i < X_.cols(); i++) {
+        for (int i = 0; i < X.cols(); i++) {
             file << "X" << i;
-            if (i < X_.cols() - 1) {
+            if (i < X.cols() - 1) {
                 file << ",";
             }
         }
         file << ",y\n";
         // Write data
-        for (int i = 0; i < X_.rows(); i++) {
-            for (int j = 0; j < X_.cols(); j++) {
-                file << X_(i, j);
-                if (j < X_.cols() - 1) {
+        for (int i = 0; i < X.rows(); i++) {
+            for (int j = 0; j < X.cols(); j++) {
+                file << X(i, j);
+                if (j < X.cols() - 1) {
                     file << ",";
                 }
             }
-            file << "," << y_(i) << "\n";
+            file << "," << y(i) << "\n";
+        }
+    }
+
+    // Save to the binary columnar cache format. Every column is stored as raw Scalars in its
+    // own 64-byte aligned block, so loadBinary can map the file without parsing or copying.
+    void saveBinary(const std::string& filename) const {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open file: " + filename);
+        }
+        const MatrixView X = xView(dense());
+        const VectorView y = yView(dense());
+        const uint64_t num_columns = X.cols() + 1;
+        const uint64_t column_bytes = X.rows() * sizeof(Scalar);
+
+        BinaryHeader header{};
+        std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+        header.version = kBinaryVersion;
+        header.byte_order = kByteOrderMark;
+        header.num_rows = X.rows();
+        header.num_columns = num_columns;
+        header.directory_offset = sizeof(BinaryHeader);
+
+        std::vector<BinaryColumn> directory(num_columns);
+        size_t offset = alignBlock(sizeof(BinaryHeader) + num_columns * sizeof(BinaryColumn));
+        for (uint64_t c = 0; c < num_columns; ++c) {
+            directory[c] = {kNativeType, c < num_columns - 1 ? Feature : Target, offset, column_bytes};
+            offset = alignBlock(offset + column_bytes);
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(BinaryColumn));
+        const char padding[kBlockAlignment] = {};
+        size_t written = sizeof(header) + directory.size() * sizeof(BinaryColumn);
+        for (uint64_t c = 0; c < num_columns; ++c) {
+            file.write(padding, directory[c].offset - written);
+            const Scalar *column = c < num_columns - 1 ? X.col(c).data() : y.data();
+            file.write(reinterpret_cast<const char*>(column), column_bytes);
+            written = directory[c].offset + column_bytes;
+        }
+        if (!file) {
+            throw std::runtime_error("Could not write file: " + filename);
+        }
+    }
+
+    // Load a file written by saveBinary. The file is memory-mapped and the features are used in
+    // place through a strided Eigen::Map, so nothing is parsed or copied and processes loading the
+    // same file share its page cache. Columns stored with another type or layout are converted.
+    static Dataset loadBinary(const std::string& filename) {
+        auto mapping = std::make_shared<MappedFile>(filename);
+        const char *base = mapping->data();
+        const size_t size = mapping->size();
+
+        BinaryHeader header;
+        if (size < sizeof(header)) {
+            throw std::runtime_error("Not a dataset cache file: " + filename);
+        }
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) != 0) {
+            throw std::runtime_error("Not a dataset cache file: " + filename);
+        }
+        if (header.version != kBinaryVersion || header.byte_order != kByteOrderMark) {
+            throw std::runtime_error("Unsupported dataset cache version or byte order: " + filename);
+        }
+        if (header.num_columns == 0 ||
+            header.directory_offset + header.num_columns * sizeof(BinaryColumn) > size) {
+            throw std::runtime_error("Corrupt dataset cache file: " + filename);
+        }
+
+        std::vector<BinaryColumn> directory(header.num_columns);
+        std::memcpy(directory.data(), base + header.directory_offset, directory.size() * sizeof(BinaryColumn));
+        const BinaryColumn *target = nullptr;
+        std::vector<const BinaryColumn*> features;
+        for (const auto &column : directory) {
+            const size_t element_size = column.type == Float64 ? sizeof(double) : sizeof(float);
+            if ((column.type != Float64 && column.type != Float32) ||
+                column.size_bytes != header.num_rows * element_size ||
+                column.offset % kBlockAlignment != 0 || column.offset + column.size_bytes > size) {
+                throw std::runtime_error("Corrupt dataset cache file: " + filename);
+            }
+            if (column.role == Target) {
+                target = &column;
+            } else {
+                features.push_back(&column);
+            }
+        }
+        if (target == nullptr) {
+            throw std::runtime_error("Dataset cache file has no target column: " + filename);
+        }
+
+        auto storage = std::make_shared<Storage>();
+        storage->rows = header.num_rows;
+        storage->cols = features.size();
+
+        // Zero-copy when all columns have the build's Scalar type and features are laid out at a constant stride
+        const size_t stride_bytes = features.size() > 1 ? features[1]->offset - features[0]->offset
+                                                        : alignBlock(std::max<size_t>(header.num_rows * sizeof(Scalar), 1));
+        bool mappable = target->type == kNativeType;
+        for (size_t c = 0; mappable && c < features.size(); ++c) {
+            mappable = features[c]->type == kNativeType &&
+                       features[c]->offset == features[0]->offset + c * stride_bytes &&
+                       stride_bytes % sizeof(Scalar) == 0 && stride_bytes >= features[c]->size_bytes;
+        }
+
+        if (mappable) {
+            storage->x_data = features.empty() ? nullptr : reinterpret_cast<const Scalar*>(base + features[0]->offset);
+            storage->y_data = reinterpret_cast<const Scalar*>(base + target->offset);
+            storage->x_stride = std::max<Eigen::Index>(stride_bytes / sizeof(Scalar), 1);
+            storage->mapping = std::move(mapping);
+            return Dataset(std::shared_ptr<const Storage>(std::move(storage)));
+        }
+
+        auto read_column = [&](const BinaryColumn &column, Scalar *out) {
+            const char *data = base + column.offset;
+            for (uint64_t r = 0; r < header.num_rows; ++r) {
+                if (column.type == Float64) {
+                    out[r] = static_cast<Scalar>(reinterpret_cast<const double*>(data)[r]);
+                } else {
+                    out[r] = static_cast<Scalar>(reinterpret_cast<const float*>(data)[r]);
+                }
+            }
+        };
+        MatrixXs X(header.num_rows, features.size());
+        VectorXs y(header.num_rows);
+        for (size_t c = 0; c < features.size(); ++c) {
+            read_column(*features[c], X.col(c).data());
         }
+        read_column(*target, y.data());
+        return Dataset(std::move(X), std::move(y));
     }
 
     void print() const {
-        std::cout << "X:\n" << X_ << "\n";
-        std::cout << "y:\n" << y_.transpose() << "\n";
+        std::cout << "X:\n" << getX() << "\n";
+        std::cout << "y:\n" << getY().transpose() << "\n";
     }
 };
 
+// How dictionary-encoded columns (CSVLoader::setCategoricalColumns) become features
+enum class CategoricalEncoding {
+    Codes,   // one column holding the category code
+    OneHot   // one 0/1 column per category
+};
+
+// Read one cell as a number: the category code for categorical columns, the parsed value otherwise
+inline bool readNumericCell(const CSVLoader &loader, size_t record, int column, Scalar &value)
+{
+    if (const CategoricalColumn *categorical = loader.getCategorical(column))
+    {
+        const uint32_t code = categorical->code(record - 1);
+        value = code;
+        return code != CategoricalColumn::kMissing;
+    }
+    return parseNumber(loader.getField(record, column), value);
+}
+
 // Add toDataset as a free function
+// Parses the selected columns in a single pass straight into the matrices; rows with a
+// missing or non-numeric cell are skipped. If valid_rows is given it receives one bit per
+// data row (header excluded) telling whether that row was kept. Categorical columns are
+// taken from their dictionary codes, never from the strings, so they do not drop rows.
 inline Dataset toDataset(const CSVLoader &loader,
                          const std::vector<std::string> &feature_columns,
-                         const std::string &target_column)
+                         const std::string &target_column,
+                         ValidityBitmap *valid_rows = nullptr,
+                         CategoricalEncoding encoding = CategoricalEncoding::Codes)
 {
-    const auto &m_data = loader.getData();
-    if (m_data.empty())
+    const size_t num_records = loader.getNumRecords();
+    if (num_records == 0)
     {
         throw std::runtime_error("No data loaded. Call load() first.");
     }
 
-    // Get indices for features and target
+    // Get indices for features and target, and where each feature starts in X
     std::vector<int> feature_indices;
+    std::vector<int> feature_offsets;
+    int num_features = 0;
     for (const auto &col : feature_columns)
     {
-        feature_indices.push_back(loader.getColumnIndex(col));
+        const int idx = loader.getColumnIndex(col);
+        const CategoricalColumn *categorical = loader.getCategorical(idx);
+        feature_indices.push_back(idx);
+        feature_offsets.push_back(num_features);
+        num_features += (categorical && encoding == CategoricalEncoding::OneHot) ? categorical->numCategories() : 1;
     }
     int target_index = loader.getColumnIndex(target_column);
+    size_t min_fields = target_index + 1;
+    for (int idx : feature_indices)
+    {
+        min_fields = std::max(min_fields, static_cast<size_t>(idx) + 1);
+    }
+
+    // Size for the worst case (every row valid) and shrink once at the end
+    const int max_rows = static_cast<int>(num_records - 1);
+    MatrixXs X(max_rows, num_features);
+    VectorXs y(max_rows);
+    if (valid_rows)
+    {
+        valid_rows->clear();
+        valid_rows->reserve(max_rows);
+    }
 
-    // First pass: count valid rows
-    int valid_rows = 0;
-    for (int i = 1; i < m_data.size(); ++i)
+    // Rows rejected because of each feature's cell, then the target's; reported once per column
+    std::vector<size_t> rejected(feature_indices.size() + 1, 0);
+
+    // A rejected row is simply overwritten by the next one
+    int current_row = 0;
+    for (size_t i = 1; i < num_records; ++i)
     { // Start from 1 to skip header
-        bool is_valid = true;
-        try
+        bool is_valid = loader.getNumFields(i) >= min_fields;
+        if (is_valid && !readNumericCell(loader, i, target_index, y(current_row)))
+        {
+            is_valid = false;
+            ++rejected.back();
+        }
+        for (size_t j = 0; is_valid && j < feature_indices.size(); ++j)
         {
-            // Check if target value is valid
-            std::stod(m_data[i][target_index]);
-            // Check if all feature values are valid
-            for (int idx : feature_indices)
+            const CategoricalColumn *categorical = loader.getCategorical(feature_indices[j]);
+            if (categorical && encoding == CategoricalEncoding::OneHot)
+            {
+                const uint32_t code = categorical->code(i - 1);
+                is_valid = code != CategoricalColumn::kMissing;
+                if (is_valid)
+                {
+                    X.row(current_row).segment(feature_offsets[j], categorical->numCategories()).setZero();
+                    X(current_row, feature_offsets[j] + code) = 1.0;
+                }
+            }
+            else
+            {
+                is_valid = readNumericCell(loader, i, feature_indices[j], X(current_row, feature_offsets[j]));
+            }
+            if (!is_valid)
             {
-                std::stod(m_data[i][idx]);
+                ++rejected[j];
             }
-            valid_rows++;
         }
-        catch (const std::exception &)
+        if (valid_rows)
         {
-            // Skip this row if any value is invalid
-            continue;
+            valid_rows->push_back(is_valid);
+        }
+        if (is_valid)
+        {
+            current_row++;
         }
     }
 
-    // Create matrices with correct size
-    Eigen::MatrixXd X(valid_rows, feature_indices.size());
-    Eigen::VectorXd y(valid_rows);
-
-    // Second pass: fill matrices with valid data
-    int current_row = 0;
-    for (int i = 1; i < m_data.size(); ++i) {  // Start from 1 to skip header
-        try {
-            // Check target value
-            if (current_row >= valid_rows) {
-                continue;
-            }
-            double target_val = std::stod(m_data[i][target_index]);
-            // Check and store feature values
-            for (int j = 0; j < feature_indices.size(); ++j) {
-                X(current_row, j) = std::stod(m_data[i][feature_indices[j]]);
-            }
-            y(current_row) = target_val;
-            current_row++;
-        } catch (const std::exception&) {
-            // Skip this row if any value is invalid
-            continue;
+    for (size_t j = 0; j < rejected.size(); ++j)
+    {
+        if (rejected[j] > 0)
+        {
+            const std::string &column = j < feature_columns.size() ? feature_columns[j] : target_column;
+            std::cerr << "Warning: skipped " << rejected[j] << " rows with a missing or non-numeric value in column '"
+                      << column << "'." << std::endl;
         }
     }
 
+    if (current_row < max_rows)
+    {
+        X.conservativeResize(current_row, Eigen::NoChange);
+        y.conservativeResize(current_row);
+    }
 
-    return Dataset(X, y);
+    return Dataset(std::move(X), std::move(y));
 }
 
 // Keep the old version for backward compatibility
-inline Dataset toDataset(const CSVLoader& loader, int target_column = -1) {
-    const auto& m_data = loader.getData();
-    if (m_data.empty()) {
+inline Dataset toDataset(const CSVLoader& loader, int target_column = -1, StandardScaler* scaler = nullptr) {
+    const size_t num_records = loader.getNumRecords();
+    if (num_records == 0) {
         throw std::runtime_error("No data loaded. Call load() first.");
     }
 
     // If target_column is -1, use the last column as target
+    const size_t num_columns = loader.getNumFields(0);
     if (target_column == -1) {
-        target_column = m_data[0].size() - 1;
+        target_column = num_columns - 1;
     }
 
-    // First pass: count valid rows
-    int valid_rows = 0;
-    for (int i = 1; i < m_data.size(); ++i) {  // Start from 1 to skip header
-        bool is_valid = true;
-        try {
-            // Check if target value is valid
-            std::stod(m_data[i][target_column]);
-            // Check if all feature values are valid
-            for (int j = 0; j < m_data[i].size(); ++j) {
-                if (j != target_column) {
-                    std::stod(m_data[i][j]);
-                }
-            }
-            valid_rows++;
-        } catch (const std::exception&) {
-            // Skip this row if any value is invalid
+    // Create matrices for the worst case (every row and column valid)
+    const int max_rows = static_cast<int>(num_records - 1);
+    const int num_cells = num_columns - 1;  // Excluding target column
+    MatrixXs X(max_rows, num_cells);
+    VectorXs y(max_rows);
+
+    // Single pass: parse straight into the matrices. A row whose target does not parse is
+    // overwritten by the next one; a feature cell that does not parse is marked NaN, since
+    // whether it rejects its row depends on whether its column holds numbers at all.
+    std::vector<size_t> record_of_row;
+    std::vector<size_t> failures(num_cells, 0);
+    int current_row = 0;
+    for (size_t i = 1; i < num_records; ++i) {  // Start from 1 to skip header
+        if (loader.getNumFields(i) != num_columns ||
+            !readNumericCell(loader, i, target_column, y(current_row))) {
             std::cout << "Skipping row " << i << " due to invalid values." << std::endl;
             continue;
         }
+        int feature_idx = 0;
+        for (size_t j = 0; j < num_columns; ++j) {
+            if (j == static_cast<size_t>(target_column)) {
+                continue;
+            }
+            if (!readNumericCell(loader, i, j, X(current_row, feature_idx))) {
+                X(current_row, feature_idx) = std::numeric_limits<Scalar>::quiet_NaN();
+                ++failures[feature_idx];
+            }
+            ++feature_idx;
+        }
+        record_of_row.push_back(i);
+        current_row++;
     }
 
-    std::cout << "Total valid rows found: " << valid_rows << std::endl;
-    std::cout << "Total data rows: " << m_data.size() - 1 << std::endl;  // -1 for header
-
-    // Create matrices with correct size
-    int num_features = m_data[0].size() - 1;  // Excluding target column
+    // Columns with no numeric cell at all (dates, names, ...) are dropped, as the old stod
+    // based loader effectively did; the remaining NaN cells reject their rows
+    std::vector<int> kept_columns;
+    for (size_t j = 0, feature_idx = 0; j < num_columns; ++j) {
+        if (j == static_cast<size_t>(target_column)) {
+            continue;
+        }
+        if (current_row > 0 && failures[feature_idx] == static_cast<size_t>(current_row)) {
+            std::cerr << "Warning: skipping non-numeric column '" << loader.getField(0, j) << "'." << std::endl;
+        } else {
+            kept_columns.push_back(static_cast<int>(feature_idx));
+        }
+        ++feature_idx;
+    }
+    const int num_features = static_cast<int>(kept_columns.size());
     std::cout << "Number of features: " << num_features << std::endl;
-    Eigen::MatrixXd X(valid_rows, num_features);
-    Eigen::VectorXd y(valid_rows);
 
-    // Second pass: fill matrices with valid data
-    int current_row = 0;
-    for (int i = 1; i < m_data.size(); ++i) {  // Start from 1 to skip header
-        try {
-            int feature_idx = 0;
-            for (int j = 0; j < m_data[i].size(); ++j) {
-                if (j == target_column) {
-                    y(current_row) = std::stod(m_data[i][j]);
-                } else if (feature_idx < num_features) {  // Add bounds check
-                    X(current_row, feature_idx) = std::stod(m_data[i][j]);
-                    feature_idx++;
-                }
-            }
-            current_row++;
-            if (current_row % 100 == 0) {  // Log progress every 100 rows
-                std::cout << "Processed " << current_row << " rows" << std::endl;
-            }
-        } catch (const std::exception&) {
-            // Skip this row if any value is invalid
-            std::cout << "Error processing row " << i << std::endl;
+    // Compact in place: row r moves to kept_rows <= r and kept column c to c' <= c
+    int kept_rows = 0;
+    for (int r = 0; r < current_row; ++r) {
+        bool is_valid = true;
+        for (int c = 0; is_valid && c < num_features; ++c) {
+            is_valid = !std::isnan(X(r, kept_columns[c]));
+        }
+        if (!is_valid) {
+            std::cout << "Skipping row " << record_of_row[r] << " due to invalid values." << std::endl;
             continue;
         }
+        for (int c = 0; c < num_features; ++c) {
+            X(kept_rows, c) = X(r, kept_columns[c]);
+        }
+        y(kept_rows) = y(r);
+        kept_rows++;
     }
 
-    std::cout << "Final current_row: " << current_row << std::endl;
+    std::cout << "Total valid rows found: " << kept_rows << std::endl;
+    std::cout << "Total data rows: " << max_rows << std::endl;
+    X.conservativeResize(kept_rows, num_features);
+    y.conservativeResize(kept_rows);
     std::cout << "Matrix X dimensions: " << X.rows() << "x" << X.cols() << std::endl;
     std::cout << "Vector y dimensions: " << y.size() << std::endl;
 
-    // Feature scaling (standardization)
-    for (int j = 0; j < X.cols(); ++j) {
-        double mean = X.col(j).mean();
-        double std = std::sqrt((X.col(j).array() - mean).square().mean());
-        if (std > 1e-10) {  // Avoid division by zero
-            X.col(j) = (X.col(j).array() - mean) / std;
-        }
+    if (X.cols() == 0) {
+        throw std::runtime_error("No numeric feature columns found.");
+    }
+    if (X.rows() == 0) {
+        throw std::runtime_error("No numeric rows found: every row has a missing or non-numeric value.");
     }
 
-    // Target scaling
-    double y_mean = y.mean();
-    double y_std = std::sqrt((y.array() - y_mean).square().mean());
-    if (y_std > 1e-10) {
-        y = (y.array() - y_mean) / y_std;
+    // Standardize features and target; the fitted scaler is handed back if asked for so the
+    // same transform can be applied to new data and predictions mapped back to target units
+    StandardScaler fitted;
+    fitted.fit(X, y);
+    fitted.transform(X);
+    fitted.transform_target(y);
+    if (scaler) {
+        *scaler = std::move(fitted);
     }
 
-    return Dataset(X, y);
+    return Dataset(std::move(X), std::move(y));
 }
@@ -0,0 +1,325 @@
+#pragma once
+#include <Eigen/Dense>
+#include "types.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include "parallel.hpp"
+
+// Accumulates the normal equations of a least-squares fit with an intercept: the Gram matrix
+// A = [X 1]^T [X 1] and the vector b = [X 1]^T y. Rows can be added in any number of batches
+// (for streamed data) and partial sums from different chunks merged, since both are plain sums.
+// Sums are kept in double whatever the Scalar type; only the lower triangle of A is maintained.
+class NormalEquations
+{
+public:
+    NormalEquations() = default;
+
+    explicit NormalEquations(int num_features) { reset(num_features); }
+
+    void reset(int num_features)
+    {
+        m_gram = Eigen::MatrixXd::Zero(num_features + 1, num_features + 1);
+        m_rhs = Eigen::VectorXd::Zero(num_features + 1);
+        m_count = 0;
+    }
+
+    // Add the rows of X and y. The rows are split into one contiguous range per thread, each
+    // thread sums its range block by block, and the partial sums are added in thread order.
+    void add(const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y, unsigned num_threads = 1)
+    {
+        addDense(X, y, nullptr, num_threads);
+    }
+
+    // Weighted rows: A += sum_i w_i x_i x_i^T and b += sum_i w_i x_i y_i (with x_i = [X_i 1]),
+    // the normal equations of weighted least squares. Weights must be non-negative.
+    void add(const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y,
+             const Eigen::Ref<const Eigen::VectorXd> &weights, unsigned num_threads = 1)
+    {
+        checkWeights(X.rows(), weights);
+        addDense(X, y, &weights, num_threads);
+    }
+
+    // Sparse rows: X^T X is formed as a sparse product, so the cost follows the nonzeros
+    void add(const SparseMatrixXs &X, const Eigen::Ref<const VectorXs> &y)
+    {
+        addSparse(X, y, Eigen::VectorXd::Ones(X.rows()));
+    }
+
+    void add(const SparseMatrixXs &X, const Eigen::Ref<const VectorXs> &y, const Eigen::Ref<const Eigen::VectorXd> &weights)
+    {
+        checkWeights(X.rows(), weights);
+        addSparse(X, y, weights);
+    }
+
+    void merge(const NormalEquations &other)
+    {
+        if (other.m_count == 0)
+        {
+            return;
+        }
+        if (m_gram.size() == 0)
+        {
+            *this = other;
+            return;
+        }
+        if (other.m_gram.rows() != m_gram.rows())
+        {
+            throw std::invalid_argument("Cannot merge normal equations over different numbers of columns.");
+        }
+        m_gram += other.m_gram;
+        m_rhs += other.m_rhs;
+        m_count += other.m_count;
+    }
+
+    // Minimize ||X w + b - y||^2 + l2 ||w||^2 (the intercept is not penalized) with an LDL^T
+    // Cholesky factorization. Returns the weights followed by the intercept.
+    Eigen::VectorXd solve(double l2 = 0.0) const
+    {
+        if (m_count == 0)
+        {
+            throw std::runtime_error("No rows have been added to the normal equations.");
+        }
+        Eigen::MatrixXd gram = m_gram;
+        gram.diagonal().head(gram.rows() - 1).array() += l2;
+        Eigen::LDLT<Eigen::MatrixXd> ldlt(gram.selfadjointView<Eigen::Lower>());
+        if (ldlt.info() != Eigen::Success)
+        {
+            throw std::runtime_error("Cholesky factorization of the normal equations failed.");
+        }
+        return ldlt.solve(m_rhs);
+    }
+
+    long long getCount() const { return m_count; }
+    const Eigen::MatrixXd &getGram() const { return m_gram; }
+    const Eigen::VectorXd &getRhs() const { return m_rhs; }
+
+private:
+    static constexpr Eigen::Index kBlockRows = 256;
+
+    static void checkWeights(Eigen::Index rows, const Eigen::Ref<const Eigen::VectorXd> &weights)
+    {
+        if (weights.size() != rows)
+        {
+            throw std::invalid_argument("X and weights must have the same number of rows.");
+        }
+        if ((weights.array() < 0).any())
+        {
+            throw std::invalid_argument("Row weights cannot be negative.");
+        }
+    }
+
+    void checkShape(Eigen::Index rows, Eigen::Index cols, Eigen::Index targets)
+    {
+        if (rows != targets)
+        {
+            throw std::invalid_argument("X and y must have the same number of rows.");
+        }
+        if (m_gram.size() == 0)
+        {
+            reset(cols);
+        }
+        if (cols + 1 != m_gram.rows())
+        {
+            throw std::invalid_argument("Number of columns does not match the accumulated normal equations.");
+        }
+    }
+
+    // weights is null for unweighted rows
+    void addDense(const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y,
+                  const Eigen::Ref<const Eigen::VectorXd> *weights, unsigned num_threads)
+    {
+        checkShape(X.rows(), X.cols(), y.size());
+        num_threads = std::min<unsigned>(resolveThreadCount(num_threads), std::max<Eigen::Index>(1, X.rows() / kBlockRows));
+        if (num_threads == 1)
+        {
+            addRange(X, y, weights, 0, X.rows(), m_gram, m_rhs);
+        }
+        else
+        {
+            std::vector<Eigen::MatrixXd> grams(num_threads, Eigen::MatrixXd::Zero(m_gram.rows(), m_gram.cols()));
+            std::vector<Eigen::VectorXd> rhs(num_threads, Eigen::VectorXd::Zero(m_rhs.size()));
+            parallelFor(0, X.rows(), num_threads, [&](size_t begin, size_t end, unsigned t) {
+                addRange(X, y, weights, begin, end, grams[t], rhs[t]);
+            });
+            for (unsigned t = 0; t < num_threads; ++t)
+            {
+                m_gram += grams[t];
+                m_rhs += rhs[t];
+            }
+        }
+        m_count += X.rows();
+    }
+
+    void addSparse(const SparseMatrixXs &X, const Eigen::Ref<const VectorXs> &y, const Eigen::Ref<const Eigen::VectorXd> &weights)
+    {
+        checkShape(X.rows(), X.cols(), y.size());
+        const Eigen::Index d = X.cols();
+        const Eigen::SparseMatrix<double> Xd = X.cast<double>();
+        const Eigen::VectorXd weighted_y = weights.cwiseProduct(y.cast<double>());
+        m_gram.topLeftCorner(d, d) += Eigen::MatrixXd(Xd.transpose() * weights.asDiagonal() * Xd);
+        m_gram.row(d).head(d) += (Xd.transpose() * weights).transpose();
+        m_gram(d, d) += weights.sum();
+        m_rhs.head(d) += Xd.transpose() * weighted_y;
+        m_rhs(d) += weighted_y.sum();
+        m_count += X.rows();
+    }
+
+    // Sum rows [begin, end) a block at a time: each block becomes [X 1] in double (its rows
+    // scaled by sqrt(w) when weighted) and is added with a rank-k update of the lower triangle
+    static void addRange(const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y,
+                         const Eigen::Ref<const Eigen::VectorXd> *weights,
+                         Eigen::Index begin, Eigen::Index end, Eigen::MatrixXd &gram, Eigen::VectorXd &rhs)
+    {
+        Eigen::MatrixXd block(std::min(kBlockRows, end - begin), X.cols() + 1);
+        Eigen::VectorXd target(block.rows());
+        for (Eigen::Index start = begin; start < end; start += kBlockRows)
+        {
+            const Eigen::Index rows = std::min(kBlockRows, end - start);
+            block.topLeftCorner(rows, X.cols()) = X.middleRows(start, rows).template cast<double>();
+            block.col(X.cols()).head(rows).setOnes();
+            target.head(rows) = y.segment(start, rows).template cast<double>();
+            if (weights)
+            {
+                const auto row_weights = weights->segment(start, rows);
+                block.topRows(rows).array().colwise() *= row_weights.cwiseSqrt().array();
+                target.head(rows).array() *= row_weights.cwiseSqrt().array();
+            }
+            gram.selfadjointView<Eigen::Lower>().rankUpdate(block.topRows(rows).transpose());
+            rhs.noalias() += block.topRows(rows).transpose() * target.head(rows);
+        }
+    }
+
+    Eigen::MatrixXd m_gram;
+    Eigen::VectorXd m_rhs;
+    long long m_count = 0;
+};
+
+// Least squares through a column-pivoted Householder QR of [X 1], which copes with
+// rank-deficient and badly conditioned X better than the normal equations. A ridge penalty is
+// added as extra rows sqrt(l2) * [I 0]. Returns the weights followed by the intercept.
+inline Eigen::VectorXd solveLeastSquaresQR(const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y, double l2 = 0.0)
+{
+    if (X.rows() != y.size())
+    {
+        throw std::invalid_argument("X and y must have the same number of rows.");
+    }
+    const Eigen::Index penalty_rows = l2 > 0 ? X.cols() : 0;
+    Eigen::MatrixXd design = Eigen::MatrixXd::Zero(X.rows() + penalty_rows, X.cols() + 1);
+    Eigen::VectorXd target = Eigen::VectorXd::Zero(design.rows());
+    design.topLeftCorner(X.rows(), X.cols()) = X.cast<double>();
+    design.col(X.cols()).head(X.rows()).setOnes();
+    target.head(X.rows()) = y.cast<double>();
+    if (penalty_rows > 0)
+    {
+        design.bottomLeftCorner(penalty_rows, X.cols()).diagonal().setConstant(std::sqrt(l2));
+    }
+    return design.colPivHouseholderQr().solve(target);
+}
+
+struct LBFGSOptions
+{
+    int max_iterations = 100;
+    int history = 10;          // number of correction pairs kept
+    double tolerance = 1e-10;  // on the relative change of the objective and the gradient norm
+};
+
+// Limited-memory BFGS with a backtracking (Armijo) line search. objective(x, gradient) returns
+// f(x) and writes its gradient. x holds the starting point and receives the minimizer.
+// Returns the number of iterations run.
+inline int minimizeLBFGS(const std::function<double(const Eigen::VectorXd &, Eigen::VectorXd &)> &objective,
+                         Eigen::VectorXd &x, const LBFGSOptions &options = LBFGSOptions())
+{
+    const Eigen::Index n = x.size();
+    const int m = std::max(1, options.history);
+    // Correction pairs live in ring buffers allocated once
+    Eigen::MatrixXd S(n, m), Y(n, m);
+    Eigen::VectorXd rho(m), alpha(m);
+    Eigen::VectorXd gradient(n), direction(n), x_new(n), gradient_new(n), s_new(n), y_new(n);
+    int num_pairs = 0;
+    int newest = -1;
+
+    double f = objective(x, gradient);
+    int iteration = 0;
+    for (; iteration < options.max_iterations; ++iteration)
+    {
+        if (gradient.norm() <= options.tolerance * std::max(1.0, x.norm()))
+        {
+            break;
+        }
+
+        // Two-loop recursion: direction = -H * gradient
+        direction = -gradient;
+        for (int k = 0; k < num_pairs; ++k)
+        {
+            const int i = (newest - k + m) % m;
+            alpha(i) = rho(i) * S.col(i).dot(direction);
+            direction -= alpha(i) * Y.col(i);
+        }
+        if (num_pairs > 0)
+        {
+            direction *= S.col(newest).dot(Y.col(newest)) / Y.col(newest).squaredNorm();
+        }
+        for (int k = num_pairs - 1; k >= 0; --k)
+        {
+            const int i = (newest - k + m) % m;
+            const double beta = rho(i) * Y.col(i).dot(direction);
+            direction += (alpha(i) - beta) * S.col(i);
+        }
+        double slope = gradient.dot(direction);
+        if (slope >= 0)
+        {
+            // Not a descent direction: restart from steepest descent
+            direction = -gradient;
+            slope = -gradient.squaredNorm();
+            num_pairs = 0;
+        }
+
+        // First iteration has no curvature information, so start from a unit-length step
+        double step = num_pairs == 0 ? std::min(1.0, 1.0 / gradient.norm()) : 1.0;
+        double f_new = f;
+        bool accepted = false;
+        for (int trial = 0; trial < 50; ++trial)
+        {
+            x_new = x + step * direction;
+            f_new = objective(x_new, gradient_new);
+            if (std::isfinite(f_new) && f_new <= f + 1e-4 * step * slope)
+            {
+                accepted = true;
+                break;
+            }
+            step *= 0.5;
+        }
+        if (!accepted)
+        {
+            break;
+        }
+
+        // Only a pair with positive curvature enters the ring (it keeps H positive definite);
+        // a rejected one must not overwrite the oldest pair still in use
+        s_new = x_new - x;
+        y_new = gradient_new - gradient;
+        const double curvature = s_new.dot(y_new);
+        if (curvature > 1e-12)
+        {
+            newest = (newest + 1) % m;
+            S.col(newest) = s_new;
+            Y.col(newest) = y_new;
+            rho(newest) = 1.0 / curvature;
+            num_pairs = std::min(num_pairs + 1, m);
+        }
+
+        const double change = std::abs(f - f_new);
+        x.swap(x_new);
+        gradient.swap(gradient_new);
+        f = f_new;
+        if (change <= options.tolerance * std::max(1.0, std::abs(f)))
+        {
+            ++iteration;
+            break;
+        }
+    }
+    return iteration;
+}
@@ -1,8 +1,11 @@
 #pragma once
 #include <Eigen/Dense>
+#include "types.hpp"
 #include <vector>
 #include <string>
 #include <stdexcept>
+#include <algorithm>
+#include <cmath>
 #include <utility>
 #include <iostream>
 #include <fstream>
@@ -13,11 +16,22 @@
 class Loss
 {
 public:
-    virtual double compute(const Eigen::VectorXd &y_true,
-                           const Eigen::VectorXd &y_pred) const = 0;
+    virtual double compute(const VectorXs &y_true,
+                           const VectorXs &y_pred) const = 0;
     // gradient w.r.t. predictions
-    virtual Eigen::VectorXd gradient(const Eigen::VectorXd &y_true,
-                                     const Eigen::VectorXd &y_pred) const = 0;
+    virtual VectorXs gradient(const VectorXs &y_true,
+                                     const VectorXs &y_pred) const = 0;
+    // Loss and its gradient w.r.t. predictions together, with the gradient written into a
+    // caller-owned buffer. Losses override this with a single pass that allocates nothing.
+    virtual double compute_with_gradient(const Eigen::Ref<const VectorXs> &y_true,
+                                         const Eigen::Ref<const VectorXs> &y_pred,
+                                         Eigen::Ref<VectorXs> gradient) const
+    {
+        const VectorXs t = y_true;
+        const VectorXs p = y_pred;
+        gradient = this->gradient(t, p);
+        return compute(t, p);
+    }
     virtual ~Loss() = default;
 };
 
@@ -27,8 +41,8 @@ class MeanSquaredError : public Loss
 {
     public:
     
-    double compute(const Eigen::VectorXd &y_true,
-                   const Eigen::VectorXd &y_pred) const override
+    double compute(const VectorXs &y_true,
+                   const VectorXs &y_pred) const override
     {
         if (y_true.size() != y_pred.size())
         {
@@ -37,8 +51,8 @@ class MeanSquaredError : public Loss
         return (y_true - y_pred).squaredNorm() / y_true.size();
     }
     
-    Eigen::VectorXd gradient(const Eigen::VectorXd &y_true,
-                             const Eigen::VectorXd &y_pred) const override
+    VectorXs gradient(const VectorXs &y_true,
+                             const VectorXs &y_pred) const override
     {
         if (y_true.size() != y_pred.size())
         {
@@ -47,6 +61,26 @@ class MeanSquaredError : public Loss
         return 2 * (y_pred - y_true) / y_true.size();
     }
 
+    double compute_with_gradient(const Eigen::Ref<const VectorXs> &y_true,
+                                 const Eigen::Ref<const VectorXs> &y_pred,
+                                 Eigen::Ref<VectorXs> gradient) const override
+    {
+        if (y_true.size() != y_pred.size() || gradient.size() != y_true.size())
+        {
+            throw std::invalid_argument("y_true, y_pred and gradient must have the same size");
+        }
+        const Eigen::Index n = y_true.size();
+        const double scale = 2.0 / n;
+        double sum = 0.0;
+        for (Eigen::Index i = 0; i < n; ++i)
+        {
+            const double diff = static_cast<double>(y_pred(i)) - y_true(i);
+            sum += diff * diff;
+            gradient(i) = static_cast<Scalar>(scale * diff);
+        }
+        return sum / n;
+    }
+
 
     std::string name() const
     {
@@ -70,8 +104,8 @@ class MeanSquaredError : public Loss
 class CrossEntropy : public Loss
 {  
     public:
-    double compute(const Eigen::VectorXd &y_true,
-                   const Eigen::VectorXd &y_pred) const override
+    double compute(const VectorXs &y_true,
+                   const VectorXs &y_pred) const override
     {
         if (y_true.size() != y_pred.size())
         {
@@ -79,8 +113,8 @@ class CrossEntropy : public Loss
         }
         return - (y_true.array() * y_pred.array().log()).sum() / y_true.size();
     }
-    Eigen::VectorXd gradient(const Eigen::VectorXd &y_true,
-                             const Eigen::VectorXd &y_pred) const override
+    VectorXs gradient(const VectorXs &y_true,
+                             const VectorXs &y_pred) const override
     {
         if (y_true.size() != y_pred.size())
         {
@@ -88,6 +122,24 @@ class CrossEntropy : public Loss
         }
         return - (y_true.array() / y_pred.array()) / y_true.size();
     }
+    double compute_with_gradient(const Eigen::Ref<const VectorXs> &y_true,
+                                 const Eigen::Ref<const VectorXs> &y_pred,
+                                 Eigen::Ref<VectorXs> gradient) const override
+    {
+        if (y_true.size() != y_pred.size() || gradient.size() != y_true.size())
+        {
+            throw std::invalid_argument("y_true, y_pred and gradient must have the same size");
+        }
+        const Eigen::Index n = y_true.size();
+        double sum = 0.0;
+        for (Eigen::Index i = 0; i < n; ++i)
+        {
+            const double p = y_pred(i);
+            sum -= y_true(i) * std::log(p);
+            gradient(i) = static_cast<Scalar>(-y_true(i) / p / n);
+        }
+        return sum / n;
+    }
     std::string name() const
     {
         return "Cross Entropy";
@@ -106,3 +158,171 @@ class CrossEntropy : public Loss
     }
 };
 
+// Binary cross entropy on predicted probabilities, with both the positive and the negative
+// term. Probabilities are clamped away from 0 and 1 so the loss stays finite.
+class BinaryCrossEntropy : public Loss
+{
+    public:
+    static constexpr double kEpsilon = 1e-12;
+
+    double compute(const VectorXs &y_true,
+                   const VectorXs &y_pred) const override
+    {
+        if (y_true.size() != y_pred.size())
+        {
+            throw std::invalid_argument("y_true and y_pred must have the same size");
+        }
+        const Eigen::ArrayXd p = y_pred.cast<double>().array().max(kEpsilon).min(1.0 - kEpsilon);
+        const Eigen::ArrayXd y = y_true.cast<double>().array();
+        return -(y * p.log() + (1.0 - y) * (1.0 - p).log()).sum() / y_true.size();
+    }
+    VectorXs gradient(const VectorXs &y_true,
+                             const VectorXs &y_pred) const override
+    {
+        if (y_true.size() != y_pred.size())
+        {
+            throw std::invalid_argument("y_true and y_pred must have the same size");
+        }
+        const Eigen::ArrayXd p = y_pred.cast<double>().array().max(kEpsilon).min(1.0 - kEpsilon);
+        const Eigen::ArrayXd y = y_true.cast<double>().array();
+        return ((p - y) / (p * (1.0 - p)) / y_true.size()).cast<Scalar>().matrix();
+    }
+    double compute_with_gradient(const Eigen::Ref<const VectorXs> &y_true,
+                                 const Eigen::Ref<const VectorXs> &y_pred,
+                                 Eigen::Ref<VectorXs> gradient) const override
+    {
+        if (y_true.size() != y_pred.size() || gradient.size() != y_true.size())
+        {
+            throw std::invalid_argument("y_true, y_pred and gradient must have the same size");
+        }
+        const Eigen::Index n = y_true.size();
+        double sum = 0.0;
+        for (Eigen::Index i = 0; i < n; ++i)
+        {
+            const double p = std::min(std::max(static_cast<double>(y_pred(i)), kEpsilon), 1.0 - kEpsilon);
+            const double y = y_true(i);
+            sum -= y * std::log(p) + (1.0 - y) * std::log(1.0 - p);
+            gradient(i) = static_cast<Scalar>((p - y) / (p * (1.0 - p)) / n);
+        }
+        return sum / n;
+    }
+    std::string name() const
+    {
+        return "Binary Cross Entropy";
+    }
+    std::string description() const
+    {
+        return "Binary Cross Entropy measures how far predicted probabilities of the positive class are from 0/1 labels, penalizing confident wrong predictions heavily.";
+    }
+    std::string formula() const
+    {
+        return "BCE = - (1/n) * Σ(y_true * log(y_pred) + (1 - y_true) * log(1 - y_pred))";
+    }
+    std::string gradient_formula() const
+    {
+        return "∂BCE/∂y_pred = (1/n) * (y_pred - y_true) / (y_pred * (1 - y_pred))";
+    }
+};
+
+// Mean cross entropy of softmax(logits) against integer class labels, for a batch whose logits
+// are stored one column per row (classes x rows), so every row's softmax runs over contiguous
+// memory. Log-softmax is formed with the log-sum-exp shift, so large logits cannot overflow.
+// The logits are overwritten with the gradient of the loss w.r.t. them, (softmax - onehot) / n.
+inline double softmaxCrossEntropy(Eigen::Ref<MatrixXs> logits, const Eigen::Ref<const VectorXs> &labels)
+{
+    if (logits.cols() != labels.size())
+    {
+        throw std::invalid_argument("logits must have one column per label");
+    }
+    const Eigen::Index n = labels.size();
+    double sum = 0.0;
+    for (Eigen::Index i = 0; i < n; ++i)
+    {
+        auto column = logits.col(i);
+        const Eigen::Index label = static_cast<Eigen::Index>(labels(i));
+        column.array() -= column.maxCoeff();
+        const double label_logit = column(label);
+        column = column.array().exp();
+        const double normalizer = column.sum();
+        sum += std::log(normalizer) - label_logit;
+        column *= static_cast<Scalar>(1.0 / (normalizer * n));
+        column(label) -= static_cast<Scalar>(1.0 / n);
+    }
+    return sum / n;
+}
+
+// Binary cross entropy on logits z rather than probabilities: the sigmoid is folded into the
+// loss, so log(1 + exp(z)) is evaluated as max(z, 0) + log1p(exp(-|z|)), which stays finite
+// for any z, and the gradient is simply sigmoid(z) - y. Each row costs one exp and one log1p.
+class BinaryCrossEntropyWithLogits : public Loss
+{
+    // Turn e = exp(-|z|), held in gradient, into (sigmoid(z) - y) / n: sigmoid(z) is 1 / (1 + e)
+    // for z >= 0 and e / (1 + e) below, so nothing overflows. Coefficient-wise, so in place.
+    static void to_gradient(const Eigen::Ref<const VectorXs> &y_true, const Eigen::Ref<const VectorXs> &y_pred,
+                            Eigen::Ref<VectorXs> gradient)
+    {
+        const auto z = y_pred.array();
+        const Scalar zero = 0;
+        const Scalar one = 1;
+        auto e = gradient.array();
+        e = ((z >= zero).select(one, e) / (one + e) - y_true.array()) / static_cast<Scalar>(y_true.size());
+    }
+
+    public:
+    double compute(const VectorXs &y_true,
+                   const VectorXs &y_pred) const override
+    {
+        if (y_true.size() != y_pred.size())
+        {
+            throw std::invalid_argument("y_true and y_pred must have the same size");
+        }
+        const auto z = y_pred.array();
+        const Scalar zero = 0;
+        return (z.max(zero) + (-z.abs()).exp().log1p() - y_true.array() * z).cast<double>().sum() / y_true.size();
+    }
+    VectorXs gradient(const VectorXs &y_true,
+                             const VectorXs &y_pred) const override
+    {
+        if (y_true.size() != y_pred.size())
+        {
+            throw std::invalid_argument("y_true and y_pred must have the same size");
+        }
+        VectorXs gradient = (-y_pred.array().abs()).exp().matrix();
+        to_gradient(y_true, y_pred, gradient);
+        return gradient;
+    }
+    double compute_with_gradient(const Eigen::Ref<const VectorXs> &y_true,
+                                 const Eigen::Ref<const VectorXs> &y_pred,
+                                 Eigen::Ref<VectorXs> gradient) const override
+    {
+        if (y_true.size() != y_pred.size() || gradient.size() != y_true.size())
+        {
+            throw std::invalid_argument("y_true, y_pred and gradient must have the same size");
+        }
+        // exp(-|z|) is computed once into the gradient buffer, read by the loss, then turned
+        // into the gradient in place
+        const auto z = y_pred.array();
+        const Scalar zero = 0;
+        auto e = gradient.array();
+        e = (-z.abs()).exp();
+        const double sum = (z.max(zero) + e.log1p() - y_true.array() * z).cast<double>().sum();
+        to_gradient(y_true, y_pred, gradient);
+        return sum / y_true.size();
+    }
+    std::string name() const
+    {
+        return "Binary Cross Entropy With Logits";
+    }
+    std::string description() const
+    {
+        return "Binary Cross Entropy computed from logits (pre-sigmoid scores), which is numerically stable for any score and has the simple gradient sigmoid(z) - y.";
+    }
+    std::string formula() const
+    {
+        return "BCE = (1/n) * Σ(log(1 + exp(z)) - y_true * z)";
+    }
+    std::string gradient_formula() const
+    {
+        return "∂BCE/∂z = (1/n) * (sigmoid(z) - y_true)";
+    }
+};
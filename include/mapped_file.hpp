@@ -0,0 +1,91 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <utility>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file.
+// The mapping is released when the object is destroyed; it can be moved but not copied.
+class MappedFile {
+    public:
+        MappedFile() = default;
+
+        explicit MappedFile(const std::string& filename) {
+            open(filename);
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept
+            : m_data{std::exchange(other.m_data, nullptr)}, m_size{std::exchange(other.m_size, 0)}
+        {
+        }
+
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                close();
+                m_data = std::exchange(other.m_data, nullptr);
+                m_size = std::exchange(other.m_size, 0);
+            }
+            return *this;
+        }
+
+        ~MappedFile() {
+            close();
+        }
+
+        void open(const std::string& filename) {
+            close();
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Could not open file: " + filename);
+            }
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw std::runtime_error("Could not stat file: " + filename);
+            }
+            m_size = static_cast<size_t>(st.st_size);
+            if (m_size == 0) {
+                // mmap rejects zero-length mappings; an empty file is just an empty view
+                ::close(fd);
+                return;
+            }
+            void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (addr == MAP_FAILED) {
+                m_size = 0;
+                throw std::runtime_error("Could not map file: " + filename);
+            }
+            m_data = addr;
+        }
+
+        void close() {
+            if (m_data != nullptr) {
+                ::munmap(m_data, m_size);
+            }
+            m_data = nullptr;
+            m_size = 0;
+        }
+
+        // Hint that the mapping will be read front to back (CSV parsing)
+        void adviseSequential() const {
+            if (m_data != nullptr) {
+                ::madvise(m_data, m_size, MADV_SEQUENTIAL);
+            }
+        }
+
+        const char* data() const { return static_cast<const char*>(m_data); }
+        size_t size() const { return m_size; }
+        std::string_view view() const { return std::string_view(data(), m_size); }
+
+    private:
+        void* m_data = nullptr;
+        size_t m_size = 0;
+};
@@ -1,7 +1,9 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <stdexcept>
 #include <Eigen/Dense>
+#include "types.hpp"
 
 // Forward declaration
 class Dataset;
@@ -9,8 +11,51 @@ class Dataset;
 class Model {
     public: 
         virtual void fit(const Dataset &train) = 0;
-        virtual Eigen::VectorXd predict(const Eigen::MatrixXd &X) const = 0;
-        virtual void update_parameters(Eigen::VectorXd gradients, double rate) = 0;
+        virtual VectorXs predict(const MatrixXs &X) const = 0;
+        // Predictions for rows of a sparse (CSR) matrix; only models with a sparse kernel override this
+        virtual VectorXs predict_sparse(const Eigen::Ref<const SparseMatrixXs> & /*X*/) const {
+            throw std::logic_error(name() + " does not support sparse input");
+        }
+        // Write predictions into a caller-owned buffer of X.rows() entries. Training loops call
+        // these once per batch; models override them to predict without allocating.
+        virtual void predict_into(const Eigen::Ref<const MatrixXs> &X, Eigen::Ref<VectorXs> out) const {
+            out = predict(X);
+        }
+        virtual void predict_sparse_into(const Eigen::Ref<const SparseMatrixXs> &X, Eigen::Ref<VectorXs> out) const {
+            out = predict_sparse(X);
+        }
+        // Outputs a training loss is computed on, written like predict_into. By default these are
+        // the predictions; a model trained on a pre-activation (such as logits) returns that instead.
+        virtual void forward(const Eigen::Ref<const MatrixXs> &X, Eigen::Ref<VectorXs> out) const {
+            predict_into(X, out);
+        }
+        virtual void forward_sparse(const Eigen::Ref<const SparseMatrixXs> &X, Eigen::Ref<VectorXs> out) const {
+            predict_sparse_into(X, out);
+        }
+        // Backward pass of a batch: given the rows X, the outputs forward wrote for them and the
+        // loss gradient w.r.t. those outputs, write the gradient w.r.t. the parameters (weights,
+        // then bias) into gradients. output_gradients may be overwritten. The default is the
+        // gradient of a linear output X w + b; models with another output function override it.
+        virtual void backward(const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> & /*outputs*/,
+                              Eigen::Ref<VectorXs> output_gradients, Eigen::Ref<VectorXs> gradients) const {
+            gradients.head(X.cols()).noalias() = X.transpose() * output_gradients;
+            gradients(X.cols()) = output_gradients.sum();
+        }
+        virtual void backward_sparse(const Eigen::Ref<const SparseMatrixXs> &X, const Eigen::Ref<const VectorXs> & /*outputs*/,
+                                     Eigen::Ref<VectorXs> output_gradients, Eigen::Ref<VectorXs> gradients) const {
+            gradients.head(X.cols()).noalias() = X.transpose() * output_gradients;
+            gradients(X.cols()) = output_gradients.sum();
+        }
+        // Move the parameters by -rate * gradients (weights, then bias)
+        virtual void update_parameters(const VectorXs &gradients, double rate) = 0;
+        // Trainable parameters as one vector (weights, then bias), for snapshots such as early
+        // stopping's best-weights restore; only parametric models override these
+        virtual VectorXs get_parameters() const {
+            throw std::logic_error(name() + " does not expose its parameters");
+        }
+        virtual void set_parameters(const VectorXs & /*parameters*/) {
+            throw std::logic_error(name() + " does not expose its parameters");
+        }
         virtual std::string name() const = 0;
         virtual std::string description() const = 0;
         virtual std::string formula() const = 0;
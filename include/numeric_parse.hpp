@@ -0,0 +1,55 @@
+#pragma once
+#include <bitset>
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+// Locale-free parse of a whole CSV cell into a double or float.
+// Surrounding whitespace and a leading '+' are accepted (as std::stod does), but unlike
+// std::stod the rest of the cell must be a number, and failure is reported instead of thrown.
+template <typename T>
+inline bool parseNumber(std::string_view text, T &value)
+{
+    const char *first = text.data();
+    const char *last = text.data() + text.size();
+    while (first != last && (*first == ' ' || *first == '\t' || *first == '\r' || *first == '\n')) ++first;
+    while (last != first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r' || last[-1] == '\n')) --last;
+    if (first != last && *first == '+') ++first;
+    if (first == last) return false;
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    return ec == std::errc() && ptr == last;
+}
+
+// One bit per row; set when the row parsed cleanly.
+class ValidityBitmap {
+    public:
+        void clear() {
+            m_words.clear();
+            m_size = 0;
+        }
+
+        void reserve(size_t n) { m_words.reserve((n + 63) / 64); }
+
+        void push_back(bool valid) {
+            if (m_size % 64 == 0) m_words.push_back(0);
+            if (valid) m_words.back() |= uint64_t{1} << (m_size % 64);
+            ++m_size;
+        }
+
+        bool test(size_t i) const { return (m_words[i / 64] >> (i % 64)) & 1; }
+        size_t size() const { return m_size; }
+
+        size_t countValid() const {
+            size_t count = 0;
+            for (uint64_t word : m_words) count += std::bitset<64>(word).count();
+            return count;
+        }
+
+        size_t countInvalid() const { return m_size - countValid(); }
+
+    private:
+        std::vector<uint64_t> m_words;
+        size_t m_size = 0;
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <Eigen/Dense>
+#include <types.hpp>
 #include <vector>
 #include <string>
 #include <stdexcept>
@@ -7,10 +8,19 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <numeric>
+#include <random>
+#include <memory>
+#include <optional>
+#include <limits>
 #include <loss.hpp>
 #include <LearningRateScheduler.hpp>
 #include <dataset.hpp>
+#include <batch_stream.hpp>
+#include <batch_prefetcher.hpp>
+#include <sparse_dataset.hpp>
 #include <model.hpp>
+#include <parallel.hpp>
 
 class Optimizer {
 public:
@@ -18,10 +28,389 @@ public:
     virtual ~Optimizer() = default;
 };
 
+// When to stop training before the epoch budget is spent
+struct EarlyStopping {
+    int patience = 5;          // epochs in a row without improvement before stopping
+    double tolerance = 1e-6;   // smallest decrease of the monitored loss that counts as an improvement
+    bool restore_best = true;  // put back the parameters of the best epoch at the end
+
+    void validate() const {
+        if (patience <= 0) {
+            throw std::invalid_argument("Early stopping patience must be positive.");
+        }
+        if (tolerance < 0.0) {
+            throw std::invalid_argument("Early stopping tolerance cannot be negative.");
+        }
+    }
+};
+
+// Follows the monitored loss epoch by epoch: the loss on a validation set when there is one,
+// otherwise the training loss of the epoch. Disabled (never stops) without settings.
+class EarlyStoppingMonitor {
+private:
+    const EarlyStopping *settings_;
+    const Dataset *validation_;
+    VectorXs validation_outputs_;  // model outputs on the validation rows, reused every epoch
+    double best_loss_ = std::numeric_limits<double>::infinity();
+    int best_epoch_ = -1;
+    int epochs_without_improvement_ = 0;
+    VectorXs best_parameters_;
+
+public:
+    EarlyStoppingMonitor(const EarlyStopping *settings, const Dataset *validation = nullptr)
+        : settings_(settings), validation_(validation) {
+        if (settings_ && validation_) {
+            validation_outputs_.resize(validation_->getNumRows());
+        }
+    }
+
+    // Record the end of an epoch; returns true when training should stop
+    bool update(Model &model, const Loss &loss, double train_loss, int epoch) {
+        if (!settings_) {
+            return false;
+        }
+        double monitored = train_loss;
+        if (validation_) {
+            model.forward(validation_->getX(), validation_outputs_);
+            monitored = loss.compute(validation_->getY(), validation_outputs_);
+            std::cout << "Epoch " << epoch + 1 << ": Validation loss = " << monitored << std::endl;
+        }
+        if (monitored < best_loss_ - settings_->tolerance) {
+            best_loss_ = monitored;
+            best_epoch_ = epoch;
+            epochs_without_improvement_ = 0;
+            if (settings_->restore_best) {
+                best_parameters_ = model.get_parameters();
+            }
+            return false;
+        }
+        if (++epochs_without_improvement_ < settings_->patience) {
+            return false;
+        }
+        std::cout << "Early stopping at epoch " << epoch + 1 << ": best epoch " << best_epoch_ + 1
+                  << ", loss = " << best_loss_ << std::endl;
+        return true;
+    }
+
+    // Call once training ends, stopped early or not
+    void finish(Model &model) const {
+        if (settings_ && settings_->restore_best && best_parameters_.size() > 0) {
+            model.set_parameters(best_parameters_);
+        }
+    }
+
+    double get_best_loss() const { return best_loss_; }
+    int get_best_epoch() const { return best_epoch_; }
+};
+
+// How GradientDescent spreads the batches of an in-memory Dataset over several threads
+enum class ParallelMode {
+    // Every batch is split across the threads; per-thread gradients are summed in thread order
+    // and applied as one update, so a run is reproducible for a given thread count
+    Synchronous,
+    // Each thread runs its own share of the batches and updates the shared model without
+    // locking (Hogwild). Updates can interleave, so runs are not reproducible; works best when
+    // gradients are sparse and collisions rare
+    Hogwild
+};
+
 class GradientDescent : public Optimizer {
 private:
     double n0_;
     bool shuffle_batches_;
+    int shuffle_block_size_ = 1;
+    double clip_norm_ = 1.0;
+    unsigned num_threads_ = 1;
+    ParallelMode parallel_mode_ = ParallelMode::Synchronous;
+    int prefetch_depth_ = 0;
+    std::optional<EarlyStopping> early_stopping_;
+    std::optional<Dataset> validation_;
+
+    EarlyStoppingMonitor make_monitor() const {
+        return EarlyStoppingMonitor(early_stopping_ ? &*early_stopping_ : nullptr, validation_ ? &*validation_ : nullptr);
+    }
+
+    // Buffers for one training step, sized once per optimize() so a step allocates nothing.
+    // gradients holds the weight gradients followed by the bias gradient.
+    struct Workspace {
+        VectorXs y_pred;
+        VectorXs pred_gradients;
+        VectorXs gradients;
+
+        void resize(int batch_size, int num_features) {
+            y_pred.resize(batch_size);
+            pred_gradients.resize(batch_size);
+            gradients.resize(num_features + 1);
+        }
+    };
+
+    // Per-thread batch buffers, step workspace and partial loss
+    struct Worker {
+        MatrixXs X;
+        VectorXs y;
+        Workspace workspace;
+        double loss = 0.0;
+        bool has_nan = false;
+
+        void resize(int batch_size, int num_features) {
+            X.resize(batch_size, num_features);
+            y.resize(batch_size);
+            workspace.resize(batch_size, num_features);
+        }
+    };
+
+    // Fill order with this epoch's row order: a seeded permutation of the rows, or of
+    // contiguous row blocks when block shuffling is on. With storage_rows (a Dataset view's
+    // row index) the order is translated to storage rows, so batches are gathered straight
+    // from the shared storage.
+    void shuffle_order(std::vector<int> &order, int epoch, const std::vector<int> *storage_rows = nullptr) const {
+        std::iota(order.begin(), order.end(), 0);
+        if (shuffle_batches_) {
+            std::default_random_engine rng(epoch);
+            if (shuffle_block_size_ <= 1) {
+                std::shuffle(order.begin(), order.end(), rng);
+            } else {
+                const int num_rows = order.size();
+                std::vector<int> blocks((num_rows + shuffle_block_size_ - 1) / shuffle_block_size_);
+                std::iota(blocks.begin(), blocks.end(), 0);
+                std::shuffle(blocks.begin(), blocks.end(), rng);
+                int pos = 0;
+                for (int block : blocks) {
+                    const int end = std::min(num_rows, (block + 1) * shuffle_block_size_);
+                    for (int row = block * shuffle_block_size_; row < end; ++row) {
+                        order[pos++] = row;
+                    }
+                }
+            }
+        }
+        if (storage_rows) {
+            for (int &row : order) {
+                row = (*storage_rows)[row];
+            }
+        }
+    }
+
+    // Copy the rows order[start, start + rows) into the leading rows of the batch buffers,
+    // one column at a time so reads stay within a column of X
+    static void gather(const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y,
+                       const std::vector<int> &order, int start, int rows,
+                       MatrixXs &X_batch, VectorXs &y_batch) {
+        const int *index = order.data() + start;
+        for (int j = 0; j < X.cols(); ++j) {
+            const Scalar *column = X.col(j).data();
+            Scalar *out = X_batch.col(j).data();
+            for (int r = 0; r < rows; ++r) {
+                out[r] = column[index[r]];
+            }
+        }
+        for (int r = 0; r < rows; ++r) {
+            y_batch(r) = y(index[r]);
+        }
+    }
+
+    // Reusable CSR arrays for one batch of sparse rows; they only grow, so after the first
+    // batches no allocation is made
+    struct SparseBatch {
+        std::vector<int> outer_index;
+        std::vector<int> inner_index;
+        std::vector<Scalar> values;
+        VectorXs y;
+    };
+
+    // Sparse counterpart of gather: copy the compressed rows order[start, start + rows) into
+    // batch and return a CSR map over it
+    static Eigen::Map<const SparseMatrixXs> gather_sparse(const SparseMatrixXs &X, const Eigen::Ref<const VectorXs> &y,
+                                                          const std::vector<int> &order, int start, int rows,
+                                                          SparseBatch &batch) {
+        const int *outer = X.outerIndexPtr();
+        const int *index = order.data() + start;
+        batch.outer_index.resize(rows + 1);
+        batch.outer_index[0] = 0;
+        for (int r = 0; r < rows; ++r) {
+            batch.outer_index[r + 1] = batch.outer_index[r] + outer[index[r] + 1] - outer[index[r]];
+        }
+        batch.inner_index.resize(batch.outer_index[rows]);
+        batch.values.resize(batch.outer_index[rows]);
+        for (int r = 0; r < rows; ++r) {
+            const int begin = outer[index[r]];
+            const int end = outer[index[r] + 1];
+            std::copy(X.innerIndexPtr() + begin, X.innerIndexPtr() + end, batch.inner_index.begin() + batch.outer_index[r]);
+            std::copy(X.valuePtr() + begin, X.valuePtr() + end, batch.values.begin() + batch.outer_index[r]);
+            batch.y(r) = y(index[r]);
+        }
+        return Eigen::Map<const SparseMatrixXs>(rows, X.cols(), batch.outer_index[rows], batch.outer_index.data(),
+                                                batch.inner_index.data(), batch.values.data());
+    }
+
+    // One gradient step on a batch; returns the batch loss. Batches with NaN predictions or gradients are skipped.
+    double step(Model &model, const Loss &loss, const Eigen::Ref<const MatrixXs> &X_batch, const Eigen::Ref<const VectorXs> &y_batch,
+                Workspace &workspace, double learning_rate) {
+        const Eigen::Index rows = X_batch.rows();
+        model.forward(X_batch, workspace.y_pred.head(rows));
+        const double batch_loss = output_gradient(loss, y_batch, workspace);
+        if (batch_loss_is_nan(workspace, rows)) {
+            return batch_loss;
+        }
+        model.backward(X_batch, workspace.y_pred.head(rows), workspace.pred_gradients.head(rows), workspace.gradients);
+        apply_update(model, workspace.gradients, learning_rate);
+        return batch_loss;
+    }
+
+    double step_sparse(Model &model, const Loss &loss, const Eigen::Ref<const SparseMatrixXs> &X_batch, const Eigen::Ref<const VectorXs> &y_batch,
+                       Workspace &workspace, double learning_rate) {
+        const Eigen::Index rows = X_batch.rows();
+        model.forward_sparse(X_batch, workspace.y_pred.head(rows));
+        const double batch_loss = output_gradient(loss, y_batch, workspace);
+        if (batch_loss_is_nan(workspace, rows)) {
+            return batch_loss;
+        }
+        model.backward_sparse(X_batch, workspace.y_pred.head(rows), workspace.pred_gradients.head(rows), workspace.gradients);
+        apply_update(model, workspace.gradients, learning_rate);
+        return batch_loss;
+    }
+
+    // Loss of a batch whose predictions are in the workspace, and its gradient with respect to
+    // the predictions, in one pass
+    static double output_gradient(const Loss &loss, const Eigen::Ref<const VectorXs> &y_batch, Workspace &workspace) {
+        const Eigen::Index rows = y_batch.size();
+        return loss.compute_with_gradient(y_batch, workspace.y_pred.head(rows), workspace.pred_gradients.head(rows));
+    }
+
+    // Check for nan values in predictions and gradients
+    static bool batch_loss_is_nan(const Workspace &workspace, Eigen::Index rows) {
+        if (workspace.y_pred.head(rows).hasNaN() || workspace.pred_gradients.head(rows).hasNaN()) {
+            std::cerr << "Warning: NaN detected in predictions or gradients. Skipping batch." << std::endl;
+            return true;
+        }
+        return false;
+    }
+
+    // Clip a batch gradient (weights, then bias) in place and hand it to the model
+    void apply_update(Model &model, VectorXs &gradients, double learning_rate) {
+        const Eigen::Index num_weights = gradients.size() - 1;
+
+        // Gradient clipping to prevent exploding gradients
+        if (clip_norm_ > 0) {
+            double grad_norm = gradients.head(num_weights).norm();
+            if (grad_norm > clip_norm_) {
+                gradients.head(num_weights) *= clip_norm_ / grad_norm;
+            }
+            Scalar &bias_gradient = gradients(num_weights);
+            if (std::abs(bias_gradient) > clip_norm_) {
+                bias_gradient = (bias_gradient > 0 ? 1.0 : -1.0) * clip_norm_;
+            }
+        }
+
+        // Check the learning rate for numerical stability
+        // A rate of 0 is valid: annealing schedules can end there
+        if (learning_rate < 0 || std::isnan(learning_rate)) {
+            std::cerr << "Warning: Invalid learning rate detected. Using default value." << std::endl;
+            learning_rate = 0.001;
+        }
+
+        // Update model parameters
+        compute_step(gradients);
+        model.update_parameters(gradients, learning_rate);
+    }
+
+    // Synchronous data-parallel step on rows order[start, start + rows): each worker gathers a
+    // slice of the batch and computes its gradient, the slices are reduced in worker order and
+    // applied once. Losses are means over rows, so each slice is weighted by its share of the batch.
+    double synchronous_step(Model &model, const Loss &loss, const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y,
+                            const std::vector<int> &order, int start, int rows, double learning_rate,
+                            ThreadPool &pool, std::vector<Worker> &workers, Workspace &workspace) {
+        const unsigned num_slices = std::min<unsigned>(workers.size(), rows);
+        pool.run(num_slices, [&](unsigned t) {
+            const int slice_begin = static_cast<long long>(rows) * t / num_slices;
+            const int slice_rows = static_cast<long long>(rows) * (t + 1) / num_slices - slice_begin;
+            Worker &worker = workers[t];
+            gather(X, y, order, start + slice_begin, slice_rows, worker.X, worker.y);
+
+            const auto X_slice = worker.X.topRows(slice_rows);
+            auto y_pred = worker.workspace.y_pred.head(slice_rows);
+            auto pred_gradients = worker.workspace.pred_gradients.head(slice_rows);
+            model.forward(X_slice, y_pred);
+            const double share = static_cast<double>(slice_rows) / rows;
+            worker.loss = loss.compute_with_gradient(worker.y.head(slice_rows), y_pred, pred_gradients) * share;
+            pred_gradients *= share;
+            worker.has_nan = y_pred.hasNaN() || pred_gradients.hasNaN();
+            model.backward(X_slice, y_pred, pred_gradients, worker.workspace.gradients);
+        });
+
+        double batch_loss = 0.0;
+        bool has_nan = false;
+        workspace.gradients.setZero();
+        for (unsigned t = 0; t < num_slices; ++t) {
+            batch_loss += workers[t].loss;
+            has_nan = has_nan || workers[t].has_nan;
+            workspace.gradients += workers[t].workspace.gradients;
+        }
+        if (has_nan) {
+            std::cerr << "Warning: NaN detected in predictions or gradients. Skipping batch." << std::endl;
+            return batch_loss;
+        }
+        apply_update(model, workspace.gradients, learning_rate);
+        return batch_loss;
+    }
+
+    // Hogwild epochs: the batches of each epoch are divided into one contiguous run per thread,
+    // and every thread steps the shared model through its run without synchronization. Only
+    // the model's parameters are shared this way; optimizers with step state are rejected.
+    void optimize_hogwild(Model &model, const Eigen::Ref<const MatrixXs> &X, const Eigen::Ref<const VectorXs> &y,
+                          const std::vector<int> *storage_rows, int num_samples,
+                          const Loss &loss, const LearningRateScheduler &scheduler, int epochs, int batchSize) {
+        const int num_batches = (num_samples + batchSize - 1) / batchSize;
+        const unsigned num_threads = std::min<unsigned>(num_threads_, num_batches);
+        std::vector<int> order(num_samples);
+        std::vector<Worker> workers(num_threads);
+        for (auto &worker : workers) {
+            worker.resize(batchSize, X.cols());
+        }
+
+        EarlyStoppingMonitor monitor = make_monitor();
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            shuffle_order(order, epoch, storage_rows);
+            parallelFor(0, num_batches, num_threads, [&](size_t batch_begin, size_t batch_end, unsigned t) {
+                Worker &worker = workers[t];
+                worker.loss = 0.0;
+                for (size_t batch = batch_begin; batch < batch_end; ++batch) {
+                    const int start = batch * batchSize;
+                    const int end = std::min(start + batchSize, num_samples);
+                    gather(X, y, order, start, end - start, worker.X, worker.y);
+                    // Steps are numbered as in serial training, whichever thread takes the batch
+                    const long long step_index = static_cast<long long>(epoch) * num_batches + batch;
+                    double batch_loss = step(model, loss, worker.X.topRows(end - start), worker.y.head(end - start),
+                                             worker.workspace, scheduler.getRate(step_index, epoch));
+                    worker.loss += batch_loss * (end - start) / num_samples;
+                }
+            });
+
+            double epoch_loss = 0.0;
+            for (const auto &worker : workers) {
+                epoch_loss += worker.loss;
+            }
+            std::cout << "Epoch " << epoch + 1 << "/" << epochs << ": Loss = " << epoch_loss << std::endl;
+            scheduler.reportLoss(epoch_loss, epoch);
+            if (monitor.update(model, loss, epoch_loss, epoch)) {
+                break;
+            }
+        }
+        monitor.finish(model);
+    }
+
+protected:
+    // Turn the clipped gradient (weights, then bias) into the step handed to update_parameters,
+    // in place. Plain gradient descent steps along the gradient itself; the adaptive optimizers
+    // below override this and keep their state in buffers sized by reset_state.
+    virtual void compute_step(VectorXs & /*gradients*/) {}
+
+    // Called at the start of every optimize() with the number of parameters (features + bias)
+    virtual void reset_state(int /*num_parameters*/) {}
+
+    // True when compute_step reads and writes state kept between steps. Hogwild workers would
+    // race on that state, so optimize() refuses the combination.
+    virtual bool has_step_state() const { return false; }
+
 public:
     GradientDescent(double n0 = 0.01, bool shuffle_batches = true)
         : n0_(n0), shuffle_batches_(shuffle_batches) {
@@ -35,11 +424,68 @@ public:
                 std::cout << "Warning: Shuffle batches is set to false. This may lead to suboptimal convergence." << std::endl;
             }  
 
-            //use gradient function
+        }
 
+    // Shuffle contiguous blocks of rows instead of single rows. Batches then read runs of
+    // adjacent rows, which is friendlier to the cache on large datasets. 1 shuffles single rows.
+    void set_shuffle_block_size(int rows) {
+        if (rows <= 0) {
+            throw std::invalid_argument("Shuffle block size must be positive.");
+        }
+        shuffle_block_size_ = rows;
+    }
+    int get_shuffle_block_size() const { return shuffle_block_size_; }
 
+    // Stop optimize() once the monitored loss has not improved by more than tolerance for
+    // patience epochs. The loss is measured on validation after every epoch when given (the
+    // Dataset is shared, not copied), otherwise it is the epoch's training loss. With
+    // restore_best the model must implement get_parameters/set_parameters.
+    void set_early_stopping(const EarlyStopping &early_stopping, const Dataset *validation = nullptr) {
+        early_stopping.validate();
+        early_stopping_ = early_stopping;
+        if (validation) {
+            validation_ = *validation;
+        } else {
+            validation_.reset();
+        }
+    }
+    void disable_early_stopping() {
+        early_stopping_.reset();
+        validation_.reset();
+    }
 
+    // Largest gradient norm let through before rescaling (applied to the weights and the bias
+    // separately); 0 turns clipping off
+    void set_clip_norm(double clip_norm) {
+        if (clip_norm < 0.0) {
+            throw std::invalid_argument("Clip norm cannot be negative.");
         }
+        clip_norm_ = clip_norm;
+    }
+    double get_clip_norm() const { return clip_norm_; }
+
+    // Train in-memory Datasets on num_threads threads (0 = one per core, 1 = serial).
+    // Parallel modes apply to optimize(Model&, const Dataset&, ...); the model's predict()
+    // must be safe to call concurrently, which holds for the library's models.
+    void set_parallelism(unsigned num_threads, ParallelMode mode = ParallelMode::Synchronous) {
+        num_threads_ = resolveThreadCount(num_threads);
+        parallel_mode_ = mode;
+    }
+    // Prepare up to depth batches ahead on a background thread (shuffling and gathering rows of a
+    // Dataset, or reading a BatchSource) while the current batch is trained on; 0 turns it off.
+    // Applies to serial training on a Dataset and to BatchSource training. Batches and their
+    // order are the same as without prefetching.
+    void set_prefetch(int depth) {
+        if (depth < 0) {
+            throw std::invalid_argument("Prefetch depth cannot be negative.");
+        }
+        prefetch_depth_ = depth;
+    }
+    int get_prefetch() const { return prefetch_depth_; }
+
+    unsigned get_num_threads() const { return num_threads_; }
+    ParallelMode get_parallel_mode() const { return parallel_mode_; }
+
     void optimize(Model &model, const Dataset &dataset, const Loss &loss, const LearningRateScheduler &scheduler, int epochs, int batchSize) override {
         if (epochs <= 0) {
             throw std::invalid_argument("Number of epochs must be positive.");
@@ -48,81 +494,347 @@ public:
             throw std::invalid_argument("Batch size must be positive and less than or equal to the number of samples.");
         }
 
-        Eigen::MatrixXd X = dataset.getX();
-        Eigen::VectorXd y = dataset.getY();
-        int num_samples = X.rows();
+        // Batches are gathered by row index, so a Dataset view is read from its storage rather
+        // than copied; order holds storage rows
+        const Eigen::Ref<const MatrixXs> X = dataset.getStorageX();
+        const Eigen::Ref<const VectorXs> y = dataset.getStorageY();
+        const std::vector<int> *storage_rows = dataset.getStorageRows();
+        int num_samples = dataset.getNumRows();
         int num_features = X.cols();
 
         if (num_samples == 0 || num_features == 0) {
             throw std::runtime_error("Dataset is empty.");
         }
+        reset_state(num_features + 1);
+        scheduler.reset();
 
+        if (num_threads_ > 1 && parallel_mode_ == ParallelMode::Hogwild) {
+            if (has_step_state()) {
+                throw std::logic_error("Hogwild training does not support optimizers with per-step state "
+                                       "(Momentum, AdaGrad, RMSProp, Adam); use ParallelMode::Synchronous.");
+            }
+            optimize_hogwild(model, X, y, storage_rows, num_samples, loss, scheduler, epochs, batchSize);
+            return;
+        }
+
+        // Epochs walk a reusable row permutation; batches are gathered into these buffers
+        std::vector<int> order(num_samples);
+        MatrixXs X_batch(batchSize, num_features);
+        VectorXs y_batch(batchSize);
+        Workspace workspace;
+        workspace.resize(batchSize, num_features);
+
+        // Synchronous mode: the calling thread works the first slice of each batch, the pool the rest
+        std::unique_ptr<ThreadPool> pool;
+        std::vector<Worker> workers;
+        if (num_threads_ > 1) {
+            pool = std::make_unique<ThreadPool>(num_threads_ - 1);
+            workers.resize(num_threads_);
+            for (auto &worker : workers) {
+                worker.resize((batchSize + num_threads_ - 1) / num_threads_, num_features);
+            }
+        }
+
+        // Serial mode with prefetching: the background thread shuffles and gathers, this one steps
+        std::unique_ptr<BatchPrefetcher> prefetcher;
+        if (!pool && prefetch_depth_ > 0) {
+            prefetcher = std::make_unique<BatchPrefetcher>(prefetch_depth_, batchSize, num_features);
+        }
+
+        EarlyStoppingMonitor monitor = make_monitor();
+        long long step_count = 0;
         double epoch_loss = 0.0;
         for (int epoch = 0; epoch < epochs; ++epoch) {
-            if (shuffle_batches_) {
-                // Get shuffled dataset and update X and y
-                Dataset shuffled = dataset.shuffle(epoch);
-                X = shuffled.getX();
-                y = shuffled.getY();
+            epoch_loss = 0.0;
+            if (prefetcher) {
+                prefetcher->start([&, epoch, start = 0](MatrixXs &X_out, VectorXs &y_out) mutable {
+                    if (start == 0) {
+                        shuffle_order(order, epoch, storage_rows);
+                    }
+                    const int rows = std::min(batchSize, num_samples - start);
+                    if (rows <= 0) {
+                        return 0;
+                    }
+                    gather(X, y, order, start, rows, X_out, y_out);
+                    start += rows;
+                    return rows;
+                });
+                while (const BatchPrefetcher::Batch *batch = prefetcher->next()) {
+                    double batch_loss = step(model, loss, batch->X.topRows(batch->rows), batch->y.head(batch->rows), workspace, scheduler.getRate(step_count++, epoch));
+                    epoch_loss += batch_loss * batch->rows / num_samples;
+                }
+            } else {
+                shuffle_order(order, epoch, storage_rows);
+            }
+
+            for (int start = 0; !prefetcher && start < num_samples; start += batchSize) {
+                int end = std::min(start + batchSize, num_samples);
+                if (pool) {
+                    double batch_loss = synchronous_step(model, loss, X, y, order, start, end - start, scheduler.getRate(step_count++, epoch), *pool, workers, workspace);
+                    epoch_loss += batch_loss * (end - start) / num_samples;
+                    continue;
+                }
+                gather(X, y, order, start, end - start, X_batch, y_batch);
+
+                double batch_loss = step(model, loss, X_batch.topRows(end - start), y_batch.head(end - start), workspace, scheduler.getRate(step_count++, epoch));
+                epoch_loss += batch_loss * (end - start) / num_samples;  // Weight by batch size
+            }
+
+            std::cout << "Epoch " << epoch + 1 << "/" << epochs << ": Loss = " << epoch_loss << std::endl;
+            scheduler.reportLoss(epoch_loss, epoch);
+            if (monitor.update(model, loss, epoch_loss, epoch)) {
+                break;
             }
+        }
+        monitor.finish(model);
+    }
+
+    // Sparse variant: each batch's rows are gathered from the dataset's CSR arrays into
+    // reusable batch arrays, so an epoch copies only the nonzeros it trains on, once
+    void optimize(Model &model, const SparseDataset &dataset, const Loss &loss, const LearningRateScheduler &scheduler, int epochs, int batchSize) {
+        if (epochs <= 0) {
+            throw std::invalid_argument("Number of epochs must be positive.");
+        }
+        if (batchSize <= 0 || batchSize > dataset.getNumRows()) {
+            throw std::invalid_argument("Batch size must be positive and less than or equal to the number of samples.");
+        }
+        const int num_samples = dataset.getNumRows();
+        if (num_samples == 0 || dataset.getNumFeatures() == 0) {
+            throw std::runtime_error("Dataset is empty.");
+        }
+        reset_state(dataset.getNumFeatures() + 1);
+        scheduler.reset();
+
+        std::vector<int> order(num_samples);
+        SparseBatch batch;
+        batch.y.resize(batchSize);
+        Workspace workspace;
+        workspace.resize(batchSize, dataset.getNumFeatures());
+
+        EarlyStoppingMonitor monitor = make_monitor();
+        long long step_count = 0;
+        double epoch_loss = 0.0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            shuffle_order(order, epoch);
 
             epoch_loss = 0.0;
             for (int start = 0; start < num_samples; start += batchSize) {
                 int end = std::min(start + batchSize, num_samples);
-                Eigen::MatrixXd X_batch = X.middleRows(start, end - start);
-                Eigen::VectorXd y_batch = y.segment(start, end - start);
+                const auto X_batch = gather_sparse(dataset.getX(), dataset.getY(), order, start, end - start, batch);
+                double batch_loss = step_sparse(model, loss, X_batch, batch.y.head(end - start),
+                                                workspace, scheduler.getRate(step_count++, epoch));
+                epoch_loss += batch_loss * (end - start) / num_samples;  // Weight by batch size
+            }
 
-                // Make predictions
-                Eigen::VectorXd y_pred = model.predict(X_batch);
+            std::cout << "Epoch " << epoch + 1 << "/" << epochs << ": Loss = " << epoch_loss << std::endl;
+            scheduler.reportLoss(epoch_loss, epoch);
+            if (monitor.update(model, loss, epoch_loss, epoch)) {
+                break;
+            }
+        }
+        monitor.finish(model);
+    }
 
-                // Compute loss and gradient
-                double batch_loss = loss.compute(y_batch, y_pred);
-                epoch_loss += batch_loss * (end - start) / num_samples;  // Weight by batch size
-                
-                // Compute gradients with respect to predictions
-                Eigen::VectorXd pred_gradients = loss.gradient(y_batch, y_pred);
-                
-                // Check for nan values in predictions and gradients
-                if (y_pred.hasNaN() || pred_gradients.hasNaN()) {
-                    std::cerr << "Warning: NaN detected in predictions or gradients. Skipping batch." << std::endl;
-                    continue;
-                }
-                
-                // Compute gradients with respect to weights and bias
-                Eigen::VectorXd weight_gradients = X_batch.transpose() * pred_gradients;
-                double bias_gradient = pred_gradients.sum();
-                
-                // Gradient clipping to prevent exploding gradients
-                double max_grad_norm = 1.0;
-                double grad_norm = weight_gradients.norm();
-                if (grad_norm > max_grad_norm) {
-                    weight_gradients *= max_grad_norm / grad_norm;
-                }
-                if (std::abs(bias_gradient) > max_grad_norm) {
-                    bias_gradient = (bias_gradient > 0 ? 1.0 : -1.0) * max_grad_norm;
-                }
-                
-                // Combine gradients
-                Eigen::VectorXd combined_gradients(weight_gradients.size() + 1);
-                combined_gradients << weight_gradients, bias_gradient;
-
-                // Get learning rate and check for numerical stability
-                double learning_rate = scheduler.getRate(epoch);
-                if (learning_rate <= 0 || std::isnan(learning_rate)) {
-                    std::cerr << "Warning: Invalid learning rate detected. Using default value." << std::endl;
-                    learning_rate = 0.001;
-                }
+    // Out-of-core variant: every epoch is one pass over the source, and only one batch (depth + 1
+    // with prefetching) is held in memory at a time. The batch size is the source's.
+    void optimize(Model &model, BatchSource &source, const Loss &loss, const LearningRateScheduler &scheduler, int epochs) {
+        if (epochs <= 0) {
+            throw std::invalid_argument("Number of epochs must be positive.");
+        }
+        if (source.getNumFeatures() == 0) {
+            throw std::runtime_error("Dataset is empty.");
+        }
+        reset_state(source.getNumFeatures() + 1);
+        scheduler.reset();
 
-                // Update model parameters
-                model.update_parameters(combined_gradients, learning_rate);
+        MatrixXs X_batch(source.getBatchSize(), source.getNumFeatures());
+        VectorXs y_batch(source.getBatchSize());
+        Workspace workspace;
+        workspace.resize(source.getBatchSize(), source.getNumFeatures());
+        // With prefetching the source is read on a background thread, depth batches ahead
+        std::unique_ptr<BatchPrefetcher> prefetcher;
+        if (prefetch_depth_ > 0) {
+            prefetcher = std::make_unique<BatchPrefetcher>(prefetch_depth_, source.getBatchSize(), source.getNumFeatures());
+        }
+        EarlyStoppingMonitor monitor = make_monitor();
+        long long step_count = 0;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            source.reset();
+            double loss_sum = 0.0;
+            long long num_samples = 0;
+            if (prefetcher) {
+                prefetcher->start([&source](MatrixXs &X_out, VectorXs &y_out) { return source.next(X_out, y_out); });
+                while (const BatchPrefetcher::Batch *batch = prefetcher->next()) {
+                    double batch_loss = step(model, loss, batch->X.topRows(batch->rows), batch->y.head(batch->rows), workspace, scheduler.getRate(step_count++, epoch));
+                    loss_sum += batch_loss * batch->rows;
+                    num_samples += batch->rows;
+                }
+            }
+            int rows = 0;
+            while (!prefetcher && (rows = source.next(X_batch, y_batch)) > 0) {
+                double batch_loss = step(model, loss, X_batch.topRows(rows), y_batch.head(rows), workspace, scheduler.getRate(step_count++, epoch));
+                loss_sum += batch_loss * rows;
+                num_samples += rows;
+            }
+            if (num_samples == 0) {
+                throw std::runtime_error("Dataset is empty.");
             }
 
-            std::cout << "Epoch " << epoch + 1 << "/" << epochs << ": Loss = " << epoch_loss << std::endl;
+            std::cout << "Epoch " << epoch + 1 << "/" << epochs << ": Loss = " << loss_sum / num_samples << std::endl;
+            scheduler.reportLoss(loss_sum / num_samples, epoch);
+            if (monitor.update(model, loss, loss_sum / num_samples, epoch)) {
+                break;
+            }
         }
+        monitor.finish(model);
     }
+
     std::string name() const;
     std::string description() const;
     std::string formula() const;
     std::string gradient_formula() const;
     ~GradientDescent() override = default;
 };
+
+// Heavy-ball momentum: v = mu * v + g, step along v. With nesterov the step looks ahead
+// along the updated velocity: g + mu * v.
+class Momentum : public GradientDescent {
+private:
+    double momentum_;
+    bool nesterov_;
+    VectorXs velocity_;
+
+protected:
+    bool has_step_state() const override { return true; }
+
+    void reset_state(int num_parameters) override {
+        velocity_ = VectorXs::Zero(num_parameters);
+    }
+
+    void compute_step(VectorXs &gradients) override {
+        velocity_ = momentum_ * velocity_ + gradients;
+        if (nesterov_) {
+            gradients += momentum_ * velocity_;
+        } else {
+            gradients = velocity_;
+        }
+    }
+
+public:
+    Momentum(double n0 = 0.01, double momentum = 0.9, bool nesterov = false, bool shuffle_batches = true)
+        : GradientDescent(n0, shuffle_batches), momentum_(momentum), nesterov_(nesterov) {
+        if (momentum < 0.0 || momentum >= 1.0) {
+            throw std::invalid_argument("Momentum must be in [0, 1).");
+        }
+    }
+
+    double get_momentum() const { return momentum_; }
+    bool is_nesterov() const { return nesterov_; }
+};
+
+// Nesterov accelerated gradient
+class Nesterov : public Momentum {
+public:
+    Nesterov(double n0 = 0.01, double momentum = 0.9, bool shuffle_batches = true)
+        : Momentum(n0, momentum, true, shuffle_batches) {}
+};
+
+// Per-parameter step scaled by the root of the accumulated squared gradients: g / (sqrt(G) + eps)
+class AdaGrad : public GradientDescent {
+private:
+    double epsilon_;
+    VectorXs accumulator_;
+
+protected:
+    bool has_step_state() const override { return true; }
+
+    void reset_state(int num_parameters) override {
+        accumulator_ = VectorXs::Zero(num_parameters);
+    }
+
+    void compute_step(VectorXs &gradients) override {
+        accumulator_.array() += gradients.array().square();
+        gradients.array() /= accumulator_.array().sqrt() + epsilon_;
+    }
+
+public:
+    AdaGrad(double n0 = 0.01, double epsilon = 1e-8, bool shuffle_batches = true)
+        : GradientDescent(n0, shuffle_batches), epsilon_(epsilon) {
+        if (epsilon <= 0.0) {
+            throw std::invalid_argument("Epsilon must be positive.");
+        }
+    }
+};
+
+// Like AdaGrad, but with an exponential moving average of the squared gradients so the
+// step size does not shrink forever
+class RMSProp : public GradientDescent {
+private:
+    double decay_;
+    double epsilon_;
+    VectorXs mean_square_;
+
+protected:
+    bool has_step_state() const override { return true; }
+
+    void reset_state(int num_parameters) override {
+        mean_square_ = VectorXs::Zero(num_parameters);
+    }
+
+    void compute_step(VectorXs &gradients) override {
+        mean_square_ = decay_ * mean_square_.array() + (1.0 - decay_) * gradients.array().square();
+        gradients.array() /= mean_square_.array().sqrt() + epsilon_;
+    }
+
+public:
+    RMSProp(double n0 = 0.001, double decay = 0.9, double epsilon = 1e-8, bool shuffle_batches = true)
+        : GradientDescent(n0, shuffle_batches), decay_(decay), epsilon_(epsilon) {
+        if (decay < 0.0 || decay >= 1.0) {
+            throw std::invalid_argument("Decay must be in [0, 1).");
+        }
+        if (epsilon <= 0.0) {
+            throw std::invalid_argument("Epsilon must be positive.");
+        }
+    }
+};
+
+// Bias-corrected moving averages of the gradient and its square: m_hat / (sqrt(v_hat) + eps)
+class Adam : public GradientDescent {
+private:
+    double beta1_;
+    double beta2_;
+    double epsilon_;
+    VectorXs first_moment_;
+    VectorXs second_moment_;
+    long long steps_ = 0;
+
+protected:
+    bool has_step_state() const override { return true; }
+
+    void reset_state(int num_parameters) override {
+        first_moment_ = VectorXs::Zero(num_parameters);
+        second_moment_ = VectorXs::Zero(num_parameters);
+        steps_ = 0;
+    }
+
+    void compute_step(VectorXs &gradients) override {
+        ++steps_;
+        first_moment_ = beta1_ * first_moment_ + (1.0 - beta1_) * gradients;
+        second_moment_ = beta2_ * second_moment_.array() + (1.0 - beta2_) * gradients.array().square();
+        const double first_correction = 1.0 - std::pow(beta1_, steps_);
+        const double second_correction = 1.0 - std::pow(beta2_, steps_);
+        gradients = (first_moment_.array() / first_correction) /
+                    ((second_moment_.array() / second_correction).sqrt() + epsilon_);
+    }
+
+public:
+    Adam(double n0 = 0.001, double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8, bool shuffle_batches = true)
+        : GradientDescent(n0, shuffle_batches), beta1_(beta1), beta2_(beta2), epsilon_(epsilon) {
+        if (beta1 < 0.0 || beta1 >= 1.0 || beta2 < 0.0 || beta2 >= 1.0) {
+            throw std::invalid_argument("Adam betas must be in [0, 1).");
+        }
+        if (epsilon <= 0.0) {
+            throw std::invalid_argument("Epsilon must be positive.");
+        }
+    }
+};
@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Number of worker threads to use; 0 means one per hardware thread
+inline unsigned resolveThreadCount(unsigned requested)
+{
+    if (requested == 0)
+    {
+        requested = std::thread::hardware_concurrency();
+    }
+    return std::max(1u, requested);
+}
+
+// Run fn(thread_index) on num_threads threads (the calling thread acts as thread 0) and wait for all of them.
+// The first exception thrown by a worker is rethrown on the calling thread.
+template <typename Fn>
+void parallelRun(unsigned num_threads, Fn &&fn)
+{
+    num_threads = std::max(1u, num_threads);
+    std::vector<std::exception_ptr> errors(num_threads);
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads - 1);
+    for (unsigned t = 1; t < num_threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            try
+            {
+                fn(t);
+            }
+            catch (...)
+            {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    try
+    {
+        fn(0u);
+    }
+    catch (...)
+    {
+        errors[0] = std::current_exception();
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    for (const auto &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Split [begin, end) into one contiguous chunk per thread and run fn(chunk_begin, chunk_end, thread_index)
+template <typename Fn>
+void parallelFor(size_t begin, size_t end, unsigned num_threads, Fn &&fn)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+    const size_t count = end - begin;
+    num_threads = static_cast<unsigned>(std::min<size_t>(std::max(1u, num_threads), count));
+    parallelRun(num_threads, [&](unsigned t) {
+        const size_t chunk_begin = begin + count * t / num_threads;
+        const size_t chunk_end = begin + count * (t + 1) / num_threads;
+        fn(chunk_begin, chunk_end, t);
+    });
+}
+
+// Fixed set of worker threads running submitted tasks in FIFO order. submit() returns a
+// future for the task's result; an exception thrown by the task is rethrown by get().
+// The destructor finishes the queued tasks before joining the workers.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned num_threads = 0)
+    {
+        num_threads = resolveThreadCount(num_threads);
+        m_workers.reserve(num_threads);
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            m_workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_ready.notify_all();
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    template <typename Fn>
+    std::future<std::invoke_result_t<std::decay_t<Fn>>> submit(Fn &&fn)
+    {
+        using Result = std::invoke_result_t<std::decay_t<Fn>>;
+        // packaged_task is move-only; std::function needs a copyable callable
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+        std::future<Result> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace([task]() { (*task)(); });
+        }
+        m_ready.notify_one();
+        return result;
+    }
+
+    // Run fn(task_index) for task_index in [0, num_tasks): task 0 on the calling thread and the
+    // rest on the pool. Waits for every task, then rethrows the first exception thrown.
+    template <typename Fn>
+    void run(unsigned num_tasks, Fn &&fn)
+    {
+        std::vector<std::future<void>> pending;
+        pending.reserve(num_tasks);
+        for (unsigned t = 1; t < num_tasks; ++t)
+        {
+            pending.push_back(submit([&fn, t]() { fn(t); }));
+        }
+        std::exception_ptr error;
+        try
+        {
+            if (num_tasks > 0)
+            {
+                fn(0u);
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        for (auto &task : pending)
+        {
+            try
+            {
+                task.get();
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+
+private:
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+                if (m_tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    bool m_stopping = false;
+};
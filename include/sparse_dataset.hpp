@@ -0,0 +1,187 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <numeric>
+#include <stdexcept>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include "types.hpp"
+#include "csv_loader.hpp"
+#include "numeric_parse.hpp"
+#include "dataset.hpp"
+
+// Dataset whose feature matrix is stored in compressed sparse row form, for one-hot or
+// hashed features that are mostly zeros. Memory and the cost of X * w and X^T * g scale
+// with the number of nonzeros instead of rows x features.
+class SparseDataset {
+    private:
+        SparseMatrixXs X_;
+        VectorXs y_;
+
+    public:
+        SparseDataset(SparseMatrixXs X, VectorXs y) : X_(std::move(X)), y_(std::move(y)) {
+            if (X_.rows() != y_.size()) {
+                throw std::invalid_argument("X and y must have the same number of rows.");
+            }
+            X_.makeCompressed();
+        }
+
+        // Build from (row, column, value) entries; duplicate entries are summed
+        static SparseDataset fromTriplets(int rows, int cols,
+                                          const std::vector<Eigen::Triplet<Scalar>> &triplets,
+                                          VectorXs y) {
+            SparseMatrixXs X(rows, cols);
+            X.setFromTriplets(triplets.begin(), triplets.end());
+            return SparseDataset(std::move(X), std::move(y));
+        }
+
+        // Keep the nonzero entries of a dense Dataset
+        static SparseDataset fromDense(const Dataset &dataset) {
+            return SparseDataset(dataset.getX().sparseView(), dataset.getY());
+        }
+
+        const SparseMatrixXs &getX() const { return X_; }
+        Eigen::Ref<const VectorXs> getY() const { return y_; }
+        int getNumRows() const { return X_.rows(); }
+        int getNumFeatures() const { return X_.cols(); }
+        Eigen::Index getNumNonZeros() const { return X_.nonZeros(); }
+
+        // Fraction of the cells of X that are stored
+        double density() const {
+            const double cells = static_cast<double>(X_.rows()) * X_.cols();
+            return cells > 0 ? X_.nonZeros() / cells : 0.0;
+        }
+
+        Dataset toDense() const { return Dataset(MatrixXs(X_), y_); }
+
+        // Copy of the given rows, in the given order
+        SparseDataset subset(const std::vector<int> &rows) const {
+            Eigen::Index nnz = 0;
+            for (int row : rows) {
+                nnz += X_.outerIndexPtr()[row + 1] - X_.outerIndexPtr()[row];
+            }
+            SparseMatrixXs X(rows.size(), X_.cols());
+            X.reserve(nnz);
+            VectorXs y(rows.size());
+            for (size_t i = 0; i < rows.size(); ++i) {
+                X.startVec(i);
+                for (SparseMatrixXs::InnerIterator it(X_, rows[i]); it; ++it) {
+                    X.insertBack(i, it.col()) = it.value();
+                }
+                y(i) = y_(rows[i]);
+            }
+            X.finalize();
+            return SparseDataset(std::move(X), std::move(y));
+        }
+
+        SparseDataset shuffle(unsigned int seed) const {
+            std::vector<int> indices(getNumRows());
+            std::iota(indices.begin(), indices.end(), 0);
+            std::shuffle(indices.begin(), indices.end(), std::default_random_engine(seed));
+            return subset(indices);
+        }
+
+        std::pair<SparseDataset, SparseDataset> trainTestSplit(double test_size = 0.2, uint seed = std::random_device{}()) const {
+            std::vector<int> indices(getNumRows());
+            std::iota(indices.begin(), indices.end(), 0);
+            std::shuffle(indices.begin(), indices.end(), std::default_random_engine(seed));
+            int num_train = static_cast<int>(getNumRows() * (1 - test_size));
+            return std::make_pair(subset(std::vector<int>(indices.begin(), indices.begin() + num_train)),
+                                  subset(std::vector<int>(indices.begin() + num_train, indices.end())));
+        }
+};
+
+// Sparse counterpart of toDataset: categorical columns are one-hot encoded and only nonzero
+// cells are stored, written straight into CSR arrays in one pass. Rows with a missing or
+// non-numeric cell are skipped and reported through valid_rows as in toDataset.
+inline SparseDataset toSparseDataset(const CSVLoader &loader,
+                                     const std::vector<std::string> &feature_columns,
+                                     const std::string &target_column,
+                                     ValidityBitmap *valid_rows = nullptr)
+{
+    const size_t num_records = loader.getNumRecords();
+    if (num_records == 0)
+    {
+        throw std::runtime_error("No data loaded. Call load() first.");
+    }
+
+    std::vector<int> feature_indices;
+    std::vector<int> feature_offsets;
+    int num_features = 0;
+    for (const auto &col : feature_columns)
+    {
+        const int idx = loader.getColumnIndex(col);
+        const CategoricalColumn *categorical = loader.getCategorical(idx);
+        feature_indices.push_back(idx);
+        feature_offsets.push_back(num_features);
+        num_features += categorical ? categorical->numCategories() : 1;
+    }
+    int target_index = loader.getColumnIndex(target_column);
+    size_t min_fields = target_index + 1;
+    for (int idx : feature_indices)
+    {
+        min_fields = std::max(min_fields, static_cast<size_t>(idx) + 1);
+    }
+
+    const int max_rows = static_cast<int>(num_records - 1);
+    std::vector<int> outer_index{0};
+    std::vector<int> inner_index;
+    std::vector<Scalar> values;
+    VectorXs y(max_rows);
+    outer_index.reserve(max_rows + 1);
+    if (valid_rows)
+    {
+        valid_rows->clear();
+        valid_rows->reserve(max_rows);
+    }
+
+    // Feature offsets increase with j, so each row's entries come out in column order.
+    // A rejected row is rolled back to where it started.
+    int current_row = 0;
+    for (size_t i = 1; i < num_records; ++i)
+    {
+        bool is_valid = loader.getNumFields(i) >= min_fields &&
+                        readNumericCell(loader, i, target_index, y(current_row));
+        for (size_t j = 0; is_valid && j < feature_indices.size(); ++j)
+        {
+            Scalar value = 1.0;
+            int column = feature_offsets[j];
+            if (const CategoricalColumn *categorical = loader.getCategorical(feature_indices[j]))
+            {
+                const uint32_t code = categorical->code(i - 1);
+                is_valid = code != CategoricalColumn::kMissing;
+                column += code;
+            }
+            else
+            {
+                is_valid = parseNumber(loader.getField(i, feature_indices[j]), value);
+            }
+            if (is_valid && value != 0)
+            {
+                inner_index.push_back(column);
+                values.push_back(value);
+            }
+        }
+        if (valid_rows)
+        {
+            valid_rows->push_back(is_valid);
+        }
+        if (is_valid)
+        {
+            outer_index.push_back(static_cast<int>(values.size()));
+            current_row++;
+        }
+        else
+        {
+            inner_index.resize(outer_index.back());
+            values.resize(outer_index.back());
+        }
+    }
+    y.conservativeResize(current_row);
+
+    const Eigen::Map<const SparseMatrixXs> X(current_row, num_features, static_cast<Eigen::Index>(values.size()),
+                                             outer_index.data(), inner_index.data(), values.data());
+    return SparseDataset(SparseMatrixXs(X), std::move(y));
+}
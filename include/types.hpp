@@ -0,0 +1,20 @@
+#pragma once
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+// Scalar type used for storage and compute across the library.
+// Build with ML_LIBRARY_USE_FLOAT defined (CMake option of the same name) to store data,
+// parameters and intermediate products in float: half the memory traffic and twice the
+// SIMD lanes of double. Losses and learning rates stay double.
+#ifdef ML_LIBRARY_USE_FLOAT
+using Scalar = float;
+#else
+using Scalar = double;
+#endif
+
+using MatrixXs = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+using VectorXs = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+using RowVectorXs = Eigen::Matrix<Scalar, 1, Eigen::Dynamic>;
+
+// Compressed sparse row matrix, so a row (sample) is one contiguous run of nonzeros
+using SparseMatrixXs = Eigen::SparseMatrix<Scalar, Eigen::RowMajor>;
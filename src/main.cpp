@@ -9,7 +9,7 @@
 #include "../include/csv_loader.hpp"
 #include "../include/dataset.hpp"
 
-void printMatrix(const Eigen::MatrixXd& matrix, const std::string& name) {
+void printMatrix(const MatrixXs& matrix, const std::string& name) {
     std::cout << "\n" << name << ":" << std::endl;
     std::cout << std::fixed << std::setprecision(4);
     for(int i = 0; i < matrix.rows(); i++) {
@@ -20,7 +20,7 @@ void printMatrix(const Eigen::MatrixXd& matrix, const std::string& name) {
     }
 }
 
-void printVector(const Eigen::VectorXd& vector, const std::string& name) {
+void printVector(const VectorXs& vector, const std::string& name) {
     std::cout << "\n" << name << ":" << std::endl;
     std::cout << std::fixed << std::setprecision(4);
     for(int i = 0; i < vector.size(); i++) {
@@ -75,8 +75,8 @@ int main() {
         pca.fit(train_set);
         
         // Transform the data
-        Eigen::MatrixXd transformed_train = pca.transform(train_set.getX());
-        Eigen::MatrixXd transformed_test = pca.transform(test_set.getX());
+        MatrixXs transformed_train = pca.transform(train_set.getX());
+        MatrixXs transformed_test = pca.transform(test_set.getX());
         
         // Print results
         std::cout << "\nOriginal feature count: " << train_set.getX().cols() << std::endl;
@@ -89,7 +89,7 @@ int main() {
         printMatrix(transformed_train.block(0, 0, 5, 2), "First 5 Transformed Training Samples");
         
         // Test inverse transform
-        Eigen::MatrixXd reconstructed = pca.inverse_transform(transformed_train);
+        MatrixXs reconstructed = pca.inverse_transform(transformed_train);
         printMatrix(reconstructed.block(0, 0, 5, reconstructed.cols()), "First 5 Reconstructed Samples");
         
         // Calculate reconstruction error